@@ -0,0 +1,408 @@
+/*
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * xfce4-fsguard-agent checks mount points on behalf of fsguard plugins
+ * running on other hosts, see fsguard-wire.h for the protocol.  It listens
+ * on a socket in the user runtime directory by default, which can be
+ * forwarded over ssh.  There is no authentication: a bare port only
+ * listens on the loopback interface, other interfaces have to be asked for
+ * by address.
+ */
+
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <glib/gstdio.h>
+#include <glib-unix.h>
+#include <gio/gunixsocketaddress.h>
+#include <libxfce4util/libxfce4util.h>
+
+#include "fsguard-check.h"
+#include "fsguard-probe.h"
+#include "fsguard-wire.h"
+
+#define CHECK_INTERVAL          8192
+#define PROBE_TIMEOUT           (4 * G_TIME_SPAN_SECOND)
+#define MAX_WATCHES             64
+/* Each hung watch holds a worker thread, so do not let this grow either */
+#define MAX_CLIENTS             16
+
+typedef struct _FsGuardClient FsGuardClient;
+
+typedef struct
+{
+    FsGuardClient      *client;
+    guint               id;
+    gboolean            mounted_only;
+    FsGuardCheck       *check;
+
+    /* last sample sent */
+    gboolean            sent;
+    gint                status;
+    guint64             total;
+    guint64             avail;
+} FsGuardWatch;
+
+struct _FsGuardClient
+{
+    FsGuardChannel     *channel;
+    GHashTable         *watches;
+};
+
+static gchar   *opt_listen = NULL;
+static gint     opt_interval = CHECK_INTERVAL;
+
+static GOptionEntry option_entries[] =
+{
+    { "listen", 'l', 0, G_OPTION_ARG_STRING, &opt_listen,
+      N_("Address to listen on: unix:PATH, PORT on loopback or ADDRESS:PORT"), N_("ADDRESS") },
+    { "interval", 'i', 0, G_OPTION_ARG_INT, &opt_interval,
+      N_("Milliseconds between two checks"), N_("MS") },
+    { NULL }
+};
+
+static GList *fsguard_clients = NULL;
+
+static void
+fsguard_watch_free (FsGuardWatch *watch)
+{
+    fsguard_check_release (watch->check);
+    g_free (watch);
+}
+
+static void
+fsguard_watch_sample (gint status, guint64 total, guint64 avail,
+                      gboolean mnt_changed, gpointer user_data)
+{
+    FsGuardWatch       *watch = user_data;
+    GByteArray         *frames;
+
+    /* Sizes are kept for when the probe comes back */
+    if (status == FSGUARD_PROBE_HUNG) {
+        total = watch->total;
+        avail = watch->avail;
+    }
+
+    if (watch->sent && !mnt_changed && watch->status == status
+        && watch->total == total && watch->avail == avail)
+        return;
+
+    frames = g_byte_array_new ();
+    fsguard_wire_put_sample (frames, watch->id,
+                             mnt_changed ? FSGUARD_WIRE_MOUNT_CHANGED : 0, status,
+                             (gint64) (total - watch->total),
+                             (gint64) (avail - watch->avail));
+    fsguard_channel_send (watch->client->channel, frames);
+    g_byte_array_unref (frames);
+
+    watch->sent = TRUE;
+    watch->status = status;
+    watch->total = total;
+    watch->avail = avail;
+}
+
+static gboolean
+fsguard_check_all (gpointer user_data)
+{
+    FsGuardClient      *client;
+    GHashTableIter      iter;
+    FsGuardWatch       *watch;
+    GList              *l;
+
+    for (l = fsguard_clients; l != NULL; l = l->next) {
+        client = l->data;
+        g_hash_table_iter_init (&iter, client->watches);
+        while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &watch))
+            fsguard_check_run (watch->check, watch->mounted_only);
+    }
+
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+fsguard_client_frame (FsGuardChannel *channel, const guint8 *payload, gsize len,
+                      gpointer user_data)
+{
+    FsGuardClient      *client = user_data;
+    FsGuardWatch       *watch;
+    const guint8       *p = payload + 1;
+    const guint8       *end = payload + len;
+    guint64             id, flags;
+    gchar              *path;
+
+    switch (payload[0]) {
+    case FSGUARD_WIRE_SUBSCRIBE:
+        if (!fsguard_wire_get_varint (&p, end, &id)
+            || !fsguard_wire_get_varint (&p, end, &flags)
+            || id > G_MAXUINT
+            || g_hash_table_contains (client->watches, GUINT_TO_POINTER ((guint) id))
+            || g_hash_table_size (client->watches) >= MAX_WATCHES)
+            return FALSE;
+
+        path = g_strndup ((const gchar *) p, end - p);
+        watch = g_new0 (FsGuardWatch, 1);
+        watch->client = client;
+        watch->id = id;
+        watch->mounted_only = (flags & FSGUARD_WIRE_MOUNTED_ONLY) != 0;
+        watch->check = fsguard_check_new (path, PROBE_TIMEOUT, fsguard_watch_sample, watch);
+        g_hash_table_insert (client->watches, GUINT_TO_POINTER (watch->id), watch);
+
+        DBG ("Watching %s", path);
+        g_free (path);
+        fsguard_check_run (watch->check, watch->mounted_only);
+        break;
+
+    case FSGUARD_WIRE_UNSUBSCRIBE:
+        if (!fsguard_wire_get_varint (&p, end, &id))
+            return FALSE;
+
+        watch = g_hash_table_lookup (client->watches, GUINT_TO_POINTER ((guint) id));
+        if (watch != NULL) {
+            g_hash_table_remove (client->watches, GUINT_TO_POINTER (watch->id));
+            fsguard_watch_free (watch);
+        }
+        break;
+
+    default:
+        /* Left for later versions of the plugin */
+        break;
+    }
+
+    return TRUE;
+}
+
+static void
+fsguard_client_closed (FsGuardChannel *channel, gpointer user_data)
+{
+    FsGuardClient      *client = user_data;
+    GHashTableIter      iter;
+    FsGuardWatch       *watch;
+
+    g_hash_table_iter_init (&iter, client->watches);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &watch))
+        fsguard_watch_free (watch);
+    g_hash_table_destroy (client->watches);
+
+    fsguard_channel_free (channel);
+    fsguard_clients = g_list_remove (fsguard_clients, client);
+    g_free (client);
+}
+
+static gboolean
+fsguard_incoming (GSocketService *service, GSocketConnection *connection,
+                  GObject *source_object, gpointer user_data)
+{
+    FsGuardClient *client;
+
+    /* Dropping the connection closes it */
+    if (g_list_length (fsguard_clients) >= MAX_CLIENTS) {
+        DBG ("Too many clients, closing connection");
+        return TRUE;
+    }
+
+    client = g_new0 (FsGuardClient, 1);
+    client->watches = g_hash_table_new (NULL, NULL);
+    client->channel = fsguard_channel_new (connection, fsguard_client_frame,
+                                           fsguard_client_closed, client);
+    fsguard_clients = g_list_prepend (fsguard_clients, client);
+
+    return TRUE;
+}
+
+/* Consumes inet_address */
+static gboolean
+fsguard_listen_inet (GSocketListener *listener, GInetAddress *inet_address, guint16 port,
+                     GError **error)
+{
+    GSocketAddress     *socket_address;
+    gboolean            ret;
+
+    socket_address = g_inet_socket_address_new (inet_address, port);
+    ret = g_socket_listener_add_address (listener, socket_address, G_SOCKET_TYPE_STREAM,
+                                         G_SOCKET_PROTOCOL_DEFAULT, NULL, NULL, error);
+    g_object_unref (socket_address);
+    g_object_unref (inet_address);
+
+    return ret;
+}
+
+/* Removes the socket of an agent which did not exit cleanly, but leaves
+ * the one of an agent still running alone */
+static gboolean
+fsguard_remove_stale (const gchar *path, GError **error)
+{
+    GSocketConnection  *connection;
+    GSocketAddress     *socket_address;
+    GSocketClient      *client;
+    GError             *connect_error = NULL;
+    struct stat         st;
+
+    if (g_lstat (path, &st) == -1 || !S_ISSOCK (st.st_mode))
+        return TRUE;
+
+    socket_address = g_unix_socket_address_new (path);
+    client = g_socket_client_new ();
+    connection = g_socket_client_connect (client, G_SOCKET_CONNECTABLE (socket_address),
+                                          NULL, &connect_error);
+    g_object_unref (client);
+    g_object_unref (socket_address);
+
+    if (connection != NULL) {
+        g_object_unref (connection);
+        g_set_error (error, G_IO_ERROR, G_IO_ERROR_ADDRESS_IN_USE,
+                     _("Another agent is listening on %s"), path);
+        return FALSE;
+    }
+
+    if (g_error_matches (connect_error, G_IO_ERROR, G_IO_ERROR_CONNECTION_REFUSED))
+        g_unlink (path);
+    g_error_free (connect_error);
+
+    return TRUE;
+}
+
+static gboolean
+fsguard_listen (GSocketListener *listener, const gchar *address, GError **error)
+{
+    GSocketAddress     *socket_address;
+    GInetAddress       *inet_address;
+    const gchar        *port;
+    gchar              *host, *end;
+    guint64             number;
+    gboolean            ret;
+
+    if (g_str_has_prefix (address, "unix:")) {
+        address += strlen ("unix:");
+
+        if (!fsguard_remove_stale (address, error))
+            return FALSE;
+
+        socket_address = g_unix_socket_address_new (address);
+        ret = g_socket_listener_add_address (listener, socket_address, G_SOCKET_TYPE_STREAM,
+                                             G_SOCKET_PROTOCOL_DEFAULT, NULL, NULL, error);
+        g_object_unref (socket_address);
+        return ret;
+    }
+
+    port = strrchr (address, ':');
+    port = (port != NULL) ? port + 1 : address;
+    number = g_ascii_strtoull (port, &end, 10);
+    if (*port == '\0' || *end != '\0' || number == 0 || number > G_MAXUINT16) {
+        g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT,
+                     _("Invalid port in %s"), address);
+        return FALSE;
+    }
+
+    /* Anybody able to connect can probe any path, do not listen on other
+     * interfaces unless asked to, e.g. with 0.0.0.0:PORT */
+    if (port == address) {
+        fsguard_listen_inet (listener, g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV6),
+                             number, NULL);
+        return fsguard_listen_inet (listener, g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV4),
+                                    number, error);
+    }
+
+    /* Brackets are optional around IPv6 addresses */
+    if (*address == '[' && port - address > 2 && port[-2] == ']')
+        host = g_strndup (address + 1, port - address - 3);
+    else
+        host = g_strndup (address, port - address - 1);
+    inet_address = g_inet_address_new_from_string (host);
+    g_free (host);
+    if (inet_address == NULL) {
+        g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT,
+                     _("Invalid address in %s"), address);
+        return FALSE;
+    }
+
+    return fsguard_listen_inet (listener, inet_address, number, error);
+}
+
+static gboolean
+fsguard_quit (gpointer user_data)
+{
+    g_main_loop_quit (user_data);
+
+    return G_SOURCE_REMOVE;
+}
+
+int
+main (int argc, char **argv)
+{
+    GOptionContext     *context;
+    GSocketService     *service;
+    GMainLoop          *loop;
+    GError             *error = NULL;
+
+    xfce_textdomain (GETTEXT_PACKAGE, PACKAGE_LOCALE_DIR, "UTF-8");
+
+    context = g_option_context_new (NULL);
+    g_option_context_set_summary (context, _("Check mount points for remote fsguard plugins"));
+    g_option_context_add_main_entries (context, option_entries, GETTEXT_PACKAGE);
+    if (!g_option_context_parse (context, &argc, &argv, &error)) {
+        g_printerr ("%s\n", error->message);
+        g_error_free (error);
+        g_option_context_free (context);
+        return EXIT_FAILURE;
+    }
+    g_option_context_free (context);
+
+    if (opt_listen == NULL)
+        opt_listen = g_strconcat ("unix:", g_get_user_runtime_dir (), G_DIR_SEPARATOR_S,
+                                  FSGUARD_AGENT_SOCKET, NULL);
+    opt_interval = MAX (opt_interval, 100);
+
+    service = g_socket_service_new ();
+    if (!fsguard_listen (G_SOCKET_LISTENER (service), opt_listen, &error)) {
+        g_printerr (_("Unable to listen on %s: %s\n"), opt_listen, error->message);
+        g_error_free (error);
+        g_object_unref (service);
+        return EXIT_FAILURE;
+    }
+    g_signal_connect (service, "incoming", G_CALLBACK (fsguard_incoming), NULL);
+    g_socket_service_start (service);
+
+    g_timeout_add (opt_interval, fsguard_check_all, NULL);
+
+    loop = g_main_loop_new (NULL, FALSE);
+    g_unix_signal_add (SIGINT, fsguard_quit, loop);
+    g_unix_signal_add (SIGTERM, fsguard_quit, loop);
+    g_main_loop_run (loop);
+
+    g_socket_service_stop (service);
+    g_socket_listener_close (G_SOCKET_LISTENER (service));
+    if (g_str_has_prefix (opt_listen, "unix:"))
+        g_unlink (opt_listen + strlen ("unix:"));
+
+    g_main_loop_unref (loop);
+    g_object_unref (service);
+    g_free (opt_listen);
+
+    return EXIT_SUCCESS;
+}
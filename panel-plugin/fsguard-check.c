@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <libxfce4util/libxfce4util.h>
+
+#include "fsguard-check.h"
+#include "fsguard-probe.h"
+#include "fsguard-worker.h"
+
+/*
+ * Runs the probe of a mount point in a worker thread, so that a stale
+ * network mount blocks the thread instead of the main loop.  The result is
+ * handed to func from the main context the check was run from, or
+ * FSGUARD_PROBE_HUNG once the probe has been blocked for longer than the
+ * timeout.
+ */
+struct _FsGuardCheck
+{
+    FsGuardCheckFunc    func;
+    gpointer            user_data;
+    GTimeSpan           timeout;
+    gboolean            hung;
+    gint64              started;
+    FsGuardWorker      *worker;
+    FsGuardProbe       *probe;
+};
+
+static void
+fsguard_check_probe (gpointer data)
+{
+    fsguard_probe_run (data);
+}
+
+static void
+fsguard_check_done (gpointer data, gpointer user_data)
+{
+    FsGuardCheck       *check = user_data;
+    FsGuardProbe       *probe = data;
+    gboolean            mnt_changed = probe->mnt_changed;
+
+    check->hung = FALSE;
+    probe->mnt_changed = FALSE;
+    check->func (probe->status, probe->total, probe->avail, mnt_changed, check->user_data);
+}
+
+FsGuardCheck *
+fsguard_check_new (const gchar      *path,
+                   GTimeSpan         timeout,
+                   FsGuardCheckFunc  func,
+                   gpointer          user_data)
+{
+    FsGuardCheck *check = g_new0 (FsGuardCheck, 1);
+
+    check->func = func;
+    check->user_data = user_data;
+    check->timeout = timeout;
+    check->probe = fsguard_probe_new (path, FALSE);
+    check->worker = fsguard_worker_new (fsguard_check_probe, fsguard_check_done, check,
+                                        check->probe, (GDestroyNotify) fsguard_probe_free);
+
+    return check;
+}
+
+void
+fsguard_check_release (FsGuardCheck *check)
+{
+    /* A probe still blocked goes away with the worker once it returns */
+    fsguard_worker_release (check->worker);
+    g_free (check);
+}
+
+void
+fsguard_check_run (FsGuardCheck *check, gboolean mounted_only)
+{
+    if (fsguard_worker_is_busy (check->worker)) {
+        /* Most likely a stale network mount, do not pile up more threads
+         * behind the blocked statfs() and let the user know instead */
+        if (!check->hung && g_get_monotonic_time () - check->started > check->timeout) {
+            DBG ("Probe of %s blocked", check->probe->path);
+            check->hung = TRUE;
+            check->func (FSGUARD_PROBE_HUNG, 0, 0, FALSE, check->user_data);
+        }
+        return;
+    }
+
+    check->started = g_get_monotonic_time ();
+    check->probe->mounted_only = mounted_only;
+    fsguard_worker_run (check->worker);
+}
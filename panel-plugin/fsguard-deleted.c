@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "fsguard-deleted.h"
+
+/* Number of processes handled by each job of the thread pool */
+#define PIDS_PER_JOB            64
+#define MAX_THREADS             8
+
+#define DELETED_SUFFIX          " (deleted)"
+
+typedef struct
+{
+    gint                pid;
+    ino_t               ino;
+    guint64             size;
+} FsGuardDeletedFile;
+
+typedef struct
+{
+    const gint         *pids;
+    guint               n_pids;
+    dev_t               dev;
+    GArray             *files;
+} FsGuardDeletedJob;
+
+static void
+fsguard_deleted_scan_pid (FsGuardDeletedJob *job, gint pid)
+{
+    FsGuardDeletedFile  file;
+    struct dirent      *entry;
+    struct stat         st;
+    DIR                *fds;
+    gchar               path[32];
+    gchar               target[PATH_MAX];
+    gssize              len;
+    guint               first = job->files->len;
+    guint               i;
+
+    g_snprintf (path, sizeof (path), "/proc/%d/fd", pid);
+    fds = opendir (path);
+    if (fds == NULL)
+        return;
+
+    while ((entry = readdir (fds)) != NULL) {
+        if (!g_ascii_isdigit (entry->d_name[0]))
+            continue;
+
+        /* Only the link itself is read here, following it could block on
+         * any stale network mount the process has files open on.  A target
+         * too long for the buffer is kept as a candidate. */
+        len = readlinkat (dirfd (fds), entry->d_name, target, sizeof (target));
+        if (len == -1)
+            continue;
+        if (len < (gssize) sizeof (target)
+            && (len < (gssize) strlen (DELETED_SUFFIX)
+                || memcmp (target + len - strlen (DELETED_SUFFIX), DELETED_SUFFIX,
+                           strlen (DELETED_SUFFIX)) != 0))
+            continue;
+
+        /* Follows the link, which still leads to the file once unlinked */
+        if (fstatat (dirfd (fds), entry->d_name, &st, 0) == -1
+            || st.st_dev != job->dev || !S_ISREG (st.st_mode) || st.st_nlink > 0)
+            continue;
+
+        /* Count a file opened several times by the same process once */
+        for (i = first; i < job->files->len; i++)
+            if (g_array_index (job->files, FsGuardDeletedFile, i).ino == st.st_ino)
+                break;
+        if (i < job->files->len)
+            continue;
+
+        file.pid = pid;
+        file.ino = st.st_ino;
+        file.size = (guint64) st.st_blocks * 512;
+        g_array_append_val (job->files, file);
+    }
+
+    closedir (fds);
+}
+
+static void
+fsguard_deleted_run_job (gpointer data, gpointer user_data)
+{
+    FsGuardDeletedJob *job = data;
+    guint              i;
+
+    for (i = 0; i < job->n_pids; i++)
+        fsguard_deleted_scan_pid (job, job->pids[i]);
+}
+
+static gint
+fsguard_deleted_compare_ino (gconstpointer a, gconstpointer b)
+{
+    const FsGuardDeletedFile *file_a = a;
+    const FsGuardDeletedFile *file_b = b;
+
+    return (file_a->ino > file_b->ino) - (file_a->ino < file_b->ino);
+}
+
+static gint
+fsguard_deleted_compare_size (gconstpointer a, gconstpointer b)
+{
+    const FsGuardHolder *holder_a = a;
+    const FsGuardHolder *holder_b = b;
+
+    return (holder_a->size < holder_b->size) - (holder_a->size > holder_b->size);
+}
+
+static void
+fsguard_deleted_read_comm (gint pid, gchar *comm, gsize size)
+{
+    gchar               path[32];
+    gssize              len = -1;
+    gint                fd;
+
+    g_snprintf (path, sizeof (path), "/proc/%d/comm", pid);
+    fd = open (path, O_RDONLY | O_CLOEXEC);
+    if (fd != -1) {
+        len = read (fd, comm, size - 1);
+        close (fd);
+    }
+
+    comm[MAX (len, 0)] = '\0';
+    g_strchomp (comm);
+}
+
+/* Walks the descriptors of every process, far too slow for the main loop */
+FsGuardDeleted *
+fsguard_deleted_scan (const gchar *path)
+{
+    FsGuardDeleted     *deleted;
+    FsGuardDeletedJob  *jobs;
+    FsGuardDeletedFile *file;
+    FsGuardHolder       holder;
+    GThreadPool        *pool;
+    GHashTable         *holders;
+    struct dirent      *entry;
+    struct stat         st;
+    gpointer            index;
+    GArray             *pids;
+    GArray             *files;
+    DIR                *proc;
+    guint               n_jobs;
+    guint               i;
+    gint                pid;
+
+    if (stat (path, &st) == -1)
+        return NULL;
+
+    proc = opendir ("/proc");
+    if (proc == NULL)
+        return NULL;
+
+    pids = g_array_new (FALSE, FALSE, sizeof (gint));
+    while ((entry = readdir (proc)) != NULL) {
+        if (!g_ascii_isdigit (entry->d_name[0]))
+            continue;
+        pid = atoi (entry->d_name);
+        if (pid > 0)
+            g_array_append_val (pids, pid);
+    }
+    closedir (proc);
+
+    /* Spread the processes over a few threads, most of the time is spent
+     * in the kernel walking the file tables */
+    n_jobs = (pids->len + PIDS_PER_JOB - 1) / PIDS_PER_JOB;
+    jobs = g_new0 (FsGuardDeletedJob, n_jobs);
+    pool = g_thread_pool_new (fsguard_deleted_run_job, NULL,
+                              CLAMP (g_get_num_processors (), 1, MAX_THREADS),
+                              FALSE, NULL);
+    for (i = 0; i < n_jobs; i++) {
+        jobs[i].pids = &g_array_index (pids, gint, i * PIDS_PER_JOB);
+        jobs[i].n_pids = MIN (PIDS_PER_JOB, pids->len - i * PIDS_PER_JOB);
+        jobs[i].dev = st.st_dev;
+        jobs[i].files = g_array_new (FALSE, FALSE, sizeof (FsGuardDeletedFile));
+        g_thread_pool_push (pool, &jobs[i], NULL);
+    }
+    g_thread_pool_free (pool, FALSE, TRUE);
+
+    files = g_array_new (FALSE, FALSE, sizeof (FsGuardDeletedFile));
+    for (i = 0; i < n_jobs; i++) {
+        g_array_append_vals (files, jobs[i].files->data, jobs[i].files->len);
+        g_array_free (jobs[i].files, TRUE);
+    }
+    g_free (jobs);
+    g_array_free (pids, TRUE);
+
+    /* A file held by several processes counts once in the total, but is
+     * accounted to each of its holders */
+    g_array_sort (files, fsguard_deleted_compare_ino);
+
+    deleted = g_new0 (FsGuardDeleted, 1);
+    deleted->holders = g_array_new (FALSE, FALSE, sizeof (FsGuardHolder));
+    holders = g_hash_table_new (NULL, NULL);
+
+    for (i = 0; i < files->len; i++) {
+        file = &g_array_index (files, FsGuardDeletedFile, i);
+        if (i == 0 || file->ino != g_array_index (files, FsGuardDeletedFile, i - 1).ino) {
+            deleted->size += file->size;
+            deleted->n_files++;
+        }
+
+        if (!g_hash_table_lookup_extended (holders, GINT_TO_POINTER (file->pid), NULL, &index)) {
+            holder.pid = file->pid;
+            holder.size = 0;
+            fsguard_deleted_read_comm (file->pid, holder.comm, sizeof (holder.comm));
+            g_array_append_val (deleted->holders, holder);
+            index = GUINT_TO_POINTER (deleted->holders->len);
+            g_hash_table_insert (holders, GINT_TO_POINTER (file->pid), index);
+        }
+        g_array_index (deleted->holders, FsGuardHolder, GPOINTER_TO_UINT (index) - 1).size += file->size;
+    }
+
+    g_hash_table_destroy (holders);
+    g_array_free (files, TRUE);
+
+    g_array_sort (deleted->holders, fsguard_deleted_compare_size);
+
+    return deleted;
+}
+
+void
+fsguard_deleted_free (FsGuardDeleted *deleted)
+{
+    g_array_free (deleted->holders, TRUE);
+    g_free (deleted);
+}
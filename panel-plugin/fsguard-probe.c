@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if defined(HAVE_STATX) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#if defined(__linux__) || defined(__GNU__)
+#include <sys/vfs.h>
+#elif defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__) || defined(__FreeBSD_kernel__)
+#include <sys/param.h>
+#include <sys/mount.h>
+#endif
+
+#include <libxfce4util/libxfce4util.h>
+
+#include "fsguard-probe.h"
+#include "fsguard-trace.h"
+
+#if defined(HAVE_STATX) && defined(STATX_MNT_ID)
+#define HAVE_STATX_MNT_ID       1
+/* Unlike plain ones, unique mount ids are not reused after an unmount,
+ * kernels without them ignore the flag and return a plain one */
+#ifdef STATX_MNT_ID_UNIQUE
+#define FSGUARD_STATX_MNT_ID    (STATX_MNT_ID | STATX_MNT_ID_UNIQUE)
+#else
+#define FSGUARD_STATX_MNT_ID    STATX_MNT_ID
+#endif
+#endif
+
+FsGuardProbe *
+fsguard_probe_new (const gchar *path, gboolean mounted_only)
+{
+    FsGuardProbe *probe = g_new0 (FsGuardProbe, 1);
+
+    probe->path = g_strdup (path);
+    probe->mounted_only = mounted_only;
+    probe->status = FSGUARD_PROBE_ERROR;
+
+    return probe;
+}
+
+void
+fsguard_probe_free (FsGuardProbe *probe)
+{
+    g_free (probe->path);
+    g_free (probe);
+}
+
+#ifdef HAVE_STATX
+static gint
+fsguard_probe_stat (FsGuardProbe *probe, gint fd, struct statfs *fsd)
+{
+    struct statx        stx;
+    guint               mask = STATX_TYPE;
+
+#ifdef HAVE_STATX_MNT_ID
+    mask |= FSGUARD_STATX_MNT_ID;
+#endif
+
+    /* Same descriptor as the fstatfs() below, a share expiring in between
+     * cannot get mounted again by it.  AT_STATX_DONT_SYNC only spares the
+     * attribute revalidation, fstatfs() still asks the server every time. */
+    if (statx (fd, "", AT_EMPTY_PATH | AT_STATX_DONT_SYNC, mask, &stx) == -1) {
+        if (errno != ENOSYS)
+            return FSGUARD_PROBE_ERROR;
+    } else {
+#ifdef STATX_ATTR_AUTOMOUNT
+        if (stx.stx_attributes & STATX_ATTR_AUTOMOUNT) {
+            DBG ("%s is an automount point, not mounted", probe->path);
+            return FSGUARD_PROBE_NOT_MOUNTED;
+        }
+#endif
+#ifdef STATX_ATTR_MOUNT_ROOT
+        if (probe->mounted_only
+            && (stx.stx_attributes_mask & STATX_ATTR_MOUNT_ROOT)
+            && !(stx.stx_attributes & STATX_ATTR_MOUNT_ROOT)) {
+            DBG ("%s is not the root of a mount", probe->path);
+            return FSGUARD_PROBE_NOT_MOUNTED;
+        }
+#endif
+#ifdef HAVE_STATX_MNT_ID
+        if ((stx.stx_mask & FSGUARD_STATX_MNT_ID) && stx.stx_mnt_id != probe->mnt_id) {
+            /* Remounted or mounted over, start over with the new filesystem.
+             * Errors in between keep the id, they are no change of mount. */
+            if (probe->mnt_id != 0) {
+                DBG ("mount id of %s changed from %" G_GUINT64_FORMAT " to %" G_GUINT64_FORMAT,
+                     probe->path, probe->mnt_id, (guint64) stx.stx_mnt_id);
+                probe->mnt_changed = TRUE;
+            }
+            probe->mnt_id = stx.stx_mnt_id;
+        }
+#endif
+    }
+
+    return (fstatfs (fd, fsd) == -1) ? FSGUARD_PROBE_ERROR : FSGUARD_PROBE_OK;
+}
+#endif
+
+static gint
+fsguard_probe_statfs (FsGuardProbe *probe, struct statfs *fsd)
+{
+#ifdef HAVE_STATX
+    gint                fd;
+    gint                status;
+
+    /* The only walk of the path per check.  Unlike a plain statfs(), an
+     * O_PATH open does not follow an automount trigger, which would mount
+     * the share and keep it from ever expiring.  Not kept across checks
+     * either, a held descriptor makes umount fail with EBUSY. */
+    fd = open (probe->path, O_PATH | O_CLOEXEC);
+    if (fd == -1)
+        return FSGUARD_PROBE_ERROR;
+    status = fsguard_probe_stat (probe, fd, fsd);
+    close (fd);
+
+    return status;
+#else
+    return (statfs (probe->path, fsd) == -1) ? FSGUARD_PROBE_ERROR : FSGUARD_PROBE_OK;
+#endif
+}
+
+/* Blocks for as long as the server of a network mount does not answer */
+gint
+fsguard_probe_run (FsGuardProbe *probe)
+{
+    struct statfs       fsd;
+
+    FSGUARD_TRACE_BEGIN (statfs);
+    probe->status = fsguard_probe_statfs (probe, &fsd);
+    FSGUARD_TRACE_END (statfs, probe->path);
+    if (probe->status == FSGUARD_PROBE_OK) {
+        probe->total = (guint64) fsd.f_blocks * fsd.f_bsize;
+        probe->avail = (guint64) fsd.f_bavail * fsd.f_bsize;
+    } else {
+        probe->total = 0;
+        probe->avail = 0;
+    }
+
+    return probe->status;
+}
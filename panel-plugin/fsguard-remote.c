@@ -0,0 +1,308 @@
+/*
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <libxfce4util/libxfce4util.h>
+
+#include "fsguard-probe.h"
+#include "fsguard-remote.h"
+#include "fsguard-wire.h"
+
+#define CONNECT_TIMEOUT         10
+#define RECONNECT_DELAY         10
+
+/*
+ * All the plugins subscribed to the same agent share a single connection,
+ * which is driven from the main loop and retried until the last of them
+ * goes away.
+ */
+typedef struct
+{
+    gchar              *address;
+    GCancellable       *cancellable;
+    FsGuardChannel     *channel;
+    guint               reconnect_id;
+    GHashTable         *subscriptions;
+    guint               next_id;
+
+    /* the callbacks may unsubscribe the last plugin */
+    gboolean            dispatching;
+    gboolean            freed;
+} FsGuardAgent;
+
+struct _FsGuardRemote
+{
+    FsGuardAgent       *agent;
+    guint               id;
+    gchar              *path;
+    gboolean            mounted_only;
+    guint64             total;
+    guint64             avail;
+    FsGuardRemoteFunc   func;
+    gpointer            user_data;
+};
+
+static GHashTable *fsguard_agents = NULL;
+
+static void fsguard_agent_connect (FsGuardAgent *agent);
+
+static void
+fsguard_agent_free (FsGuardAgent *agent)
+{
+    if (agent->cancellable != NULL) {
+        g_cancellable_cancel (agent->cancellable);
+        g_object_unref (agent->cancellable);
+    }
+    if (agent->channel != NULL)
+        fsguard_channel_free (agent->channel);
+    if (agent->reconnect_id != 0)
+        g_source_remove (agent->reconnect_id);
+
+    g_hash_table_destroy (agent->subscriptions);
+    g_free (agent->address);
+    g_free (agent);
+}
+
+static void
+fsguard_remote_put_subscribe (FsGuardRemote *remote, GByteArray *frames)
+{
+    fsguard_wire_put_subscribe (frames, remote->id,
+                                remote->mounted_only ? FSGUARD_WIRE_MOUNTED_ONLY : 0,
+                                remote->path);
+}
+
+static gboolean
+fsguard_agent_reconnect (gpointer user_data)
+{
+    FsGuardAgent *agent = user_data;
+
+    agent->reconnect_id = 0;
+    fsguard_agent_connect (agent);
+
+    return G_SOURCE_REMOVE;
+}
+
+static void
+fsguard_agent_lost (FsGuardAgent *agent)
+{
+    FsGuardRemote      *remote;
+    GList              *ids, *l;
+
+    agent->reconnect_id = g_timeout_add_seconds (RECONNECT_DELAY, fsguard_agent_reconnect, agent);
+
+    /* Samples start over from zero on the next connection */
+    agent->dispatching = TRUE;
+    ids = g_hash_table_get_keys (agent->subscriptions);
+    for (l = ids; l != NULL && !agent->freed; l = l->next) {
+        remote = g_hash_table_lookup (agent->subscriptions, l->data);
+        if (remote == NULL)
+            continue;
+        remote->total = 0;
+        remote->avail = 0;
+        remote->func (FSGUARD_PROBE_HUNG, 0, 0, FALSE, remote->user_data);
+    }
+    g_list_free (ids);
+    agent->dispatching = FALSE;
+
+    if (agent->freed)
+        fsguard_agent_free (agent);
+}
+
+static gboolean
+fsguard_agent_frame (FsGuardChannel *channel, const guint8 *payload, gsize len, gpointer user_data)
+{
+    FsGuardAgent       *agent = user_data;
+    FsGuardRemote      *remote;
+    const guint8       *p = payload + 1;
+    const guint8       *end = payload + len;
+    guint64             id, flags, status;
+    gint64              total_delta, avail_delta;
+
+    /* Left for later versions of the agent */
+    if (payload[0] != FSGUARD_WIRE_SAMPLE)
+        return TRUE;
+
+    if (!fsguard_wire_get_varint (&p, end, &id)
+        || !fsguard_wire_get_varint (&p, end, &flags)
+        || !fsguard_wire_get_varint (&p, end, &status)
+        || !fsguard_wire_get_svarint (&p, end, &total_delta)
+        || !fsguard_wire_get_svarint (&p, end, &avail_delta))
+        return FALSE;
+
+    /* Still on its way when the plugin unsubscribed */
+    remote = g_hash_table_lookup (agent->subscriptions, GUINT_TO_POINTER ((guint) id));
+    if (remote == NULL)
+        return TRUE;
+
+    remote->total += total_delta;
+    remote->avail += avail_delta;
+    remote->func ((gint) status, remote->total, remote->avail,
+                  (flags & FSGUARD_WIRE_MOUNT_CHANGED) != 0, remote->user_data);
+
+    return TRUE;
+}
+
+static void
+fsguard_agent_closed (FsGuardChannel *channel, gpointer user_data)
+{
+    FsGuardAgent *agent = user_data;
+
+    DBG ("Lost connection to %s", agent->address);
+    fsguard_channel_free (channel);
+    agent->channel = NULL;
+    fsguard_agent_lost (agent);
+}
+
+static void
+fsguard_agent_connected (GObject *source, GAsyncResult *result, gpointer user_data)
+{
+    FsGuardAgent       *agent;
+    FsGuardRemote      *remote;
+    GSocketConnection  *connection;
+    GHashTableIter      iter;
+    GByteArray         *frames;
+    GError             *error = NULL;
+
+    connection = g_socket_client_connect_finish (G_SOCKET_CLIENT (source), result, &error);
+    if (connection == NULL) {
+        /* The agent is gone when cancelled */
+        if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+            agent = user_data;
+            DBG ("Unable to connect to %s: %s", agent->address, error->message);
+            g_clear_object (&agent->cancellable);
+            fsguard_agent_lost (agent);
+        }
+        g_error_free (error);
+        return;
+    }
+
+    agent = user_data;
+    g_clear_object (&agent->cancellable);
+    agent->channel = fsguard_channel_new (connection, fsguard_agent_frame,
+                                          fsguard_agent_closed, agent);
+    g_object_unref (connection);
+
+    frames = g_byte_array_new ();
+    g_hash_table_iter_init (&iter, agent->subscriptions);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &remote))
+        fsguard_remote_put_subscribe (remote, frames);
+    fsguard_channel_send (agent->channel, frames);
+    g_byte_array_unref (frames);
+}
+
+static void
+fsguard_agent_connect (FsGuardAgent *agent)
+{
+    GSocketConnectable *connectable;
+    GSocketClient      *client;
+    GError             *error = NULL;
+
+    connectable = fsguard_wire_parse_address (agent->address, &error);
+    if (connectable == NULL) {
+        g_warning ("Invalid agent address %s: %s", agent->address, error->message);
+        g_error_free (error);
+        fsguard_agent_lost (agent);
+        return;
+    }
+
+    agent->cancellable = g_cancellable_new ();
+    client = g_socket_client_new ();
+    g_socket_client_set_timeout (client, CONNECT_TIMEOUT);
+    g_socket_client_connect_async (client, connectable, agent->cancellable,
+                                   fsguard_agent_connected, agent);
+    g_object_unref (client);
+    g_object_unref (connectable);
+}
+
+FsGuardRemote *
+fsguard_remote_subscribe (const gchar       *address,
+                          const gchar       *path,
+                          gboolean           mounted_only,
+                          FsGuardRemoteFunc  func,
+                          gpointer           user_data)
+{
+    FsGuardAgent       *agent;
+    FsGuardRemote      *remote;
+    GByteArray         *frames;
+
+    if (fsguard_agents == NULL)
+        fsguard_agents = g_hash_table_new (g_str_hash, g_str_equal);
+
+    agent = g_hash_table_lookup (fsguard_agents, address);
+    if (agent == NULL) {
+        agent = g_new0 (FsGuardAgent, 1);
+        agent->address = g_strdup (address);
+        agent->subscriptions = g_hash_table_new (NULL, NULL);
+        agent->next_id = 1;
+        g_hash_table_insert (fsguard_agents, agent->address, agent);
+
+        /* Connection failures are reported like lost connections, which
+         * must not happen before the caller got its handle */
+        agent->reconnect_id = g_idle_add (fsguard_agent_reconnect, agent);
+    }
+
+    remote = g_new0 (FsGuardRemote, 1);
+    remote->agent = agent;
+    remote->id = agent->next_id++;
+    remote->path = g_strdup (path);
+    remote->mounted_only = mounted_only;
+    remote->func = func;
+    remote->user_data = user_data;
+    g_hash_table_insert (agent->subscriptions, GUINT_TO_POINTER (remote->id), remote);
+
+    /* Otherwise sent once connected */
+    if (agent->channel != NULL) {
+        frames = g_byte_array_new ();
+        fsguard_remote_put_subscribe (remote, frames);
+        fsguard_channel_send (agent->channel, frames);
+        g_byte_array_unref (frames);
+    }
+
+    return remote;
+}
+
+void
+fsguard_remote_unsubscribe (FsGuardRemote *remote)
+{
+    FsGuardAgent       *agent = remote->agent;
+    GByteArray         *frames;
+
+    g_hash_table_remove (agent->subscriptions, GUINT_TO_POINTER (remote->id));
+    g_free (remote->path);
+
+    if (g_hash_table_size (agent->subscriptions) == 0) {
+        g_hash_table_remove (fsguard_agents, agent->address);
+        if (agent->dispatching)
+            agent->freed = TRUE;
+        else
+            fsguard_agent_free (agent);
+    } else if (agent->channel != NULL) {
+        frames = g_byte_array_new ();
+        fsguard_wire_put_unsubscribe (frames, remote->id);
+        fsguard_channel_send (agent->channel, frames);
+        g_byte_array_unref (frames);
+    }
+
+    g_free (remote);
+}
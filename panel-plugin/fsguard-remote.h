@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __FSGUARD_REMOTE_H__
+#define __FSGUARD_REMOTE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _FsGuardRemote FsGuardRemote;
+
+/* status is one of FSGUARD_PROBE_*, sizes are in bytes */
+typedef void (*FsGuardRemoteFunc) (gint      status,
+                                   guint64   total,
+                                   guint64   avail,
+                                   gboolean  mnt_changed,
+                                   gpointer  user_data);
+
+FsGuardRemote *fsguard_remote_subscribe   (const gchar       *address,
+                                           const gchar       *path,
+                                           gboolean           mounted_only,
+                                           FsGuardRemoteFunc  func,
+                                           gpointer           user_data);
+void           fsguard_remote_unsubscribe (FsGuardRemote     *remote);
+
+G_END_DECLS
+
+#endif /* !__FSGUARD_REMOTE_H__ */
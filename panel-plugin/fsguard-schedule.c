@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <libxfce4util/libxfce4util.h>
+
+#include "fsguard-schedule.h"
+
+/*
+ * Runs the periodic checks, paused while the plugin is hidden or the
+ * session idle or locked, and spaced out on battery.  Starts paused until
+ * the plugin gets mapped.
+ */
+struct _FsGuardSchedule
+{
+    FsGuardScheduleFunc func;
+    gpointer            user_data;
+    guint               interval_ac;
+    guint               interval_battery;
+    guint               interval;
+    guint               timeout;
+    gboolean            mapped;
+    gboolean            idle;
+    gboolean            locked;
+    gboolean            on_battery;
+};
+
+static gboolean
+fsguard_schedule_cb (gpointer user_data)
+{
+    FsGuardSchedule *schedule = user_data;
+
+    schedule->func (schedule->user_data);
+    return G_SOURCE_CONTINUE;
+}
+
+static void
+fsguard_schedule_update (FsGuardSchedule *schedule)
+{
+    gboolean            paused;
+    guint               interval;
+
+    /* Nobody is looking, do not wake up the disks for nothing */
+    paused = !schedule->mapped || schedule->idle || schedule->locked;
+    interval = schedule->on_battery ? schedule->interval_battery : schedule->interval_ac;
+
+    if (schedule->timeout != 0) {
+        if (!paused && interval == schedule->interval)
+            return;
+        g_source_remove (schedule->timeout);
+        schedule->timeout = 0;
+    } else if (!paused) {
+        /* Resuming, catch up with what happened in the meantime */
+        schedule->func (schedule->user_data);
+    }
+
+    DBG ("%s checks (interval %u ms)", paused ? "Pause" : "Schedule", interval);
+    if (paused) {
+        schedule->interval = 0;
+        return;
+    }
+
+    schedule->interval = interval;
+    schedule->timeout = g_timeout_add (interval, fsguard_schedule_cb, schedule);
+}
+
+FsGuardSchedule *
+fsguard_schedule_new (guint interval, guint interval_battery,
+                      FsGuardScheduleFunc func, gpointer user_data)
+{
+    FsGuardSchedule *schedule = g_new0 (FsGuardSchedule, 1);
+
+    schedule->func = func;
+    schedule->user_data = user_data;
+    schedule->interval_ac = interval;
+    schedule->interval_battery = interval_battery;
+
+    return schedule;
+}
+
+void
+fsguard_schedule_set_mapped (FsGuardSchedule *schedule, gboolean mapped)
+{
+    schedule->mapped = mapped;
+    fsguard_schedule_update (schedule);
+}
+
+void
+fsguard_schedule_set_session (FsGuardSchedule *schedule, gboolean idle,
+                              gboolean locked, gboolean on_battery)
+{
+    schedule->idle = idle;
+    schedule->locked = locked;
+    schedule->on_battery = on_battery;
+    fsguard_schedule_update (schedule);
+}
+
+/* The interval of the running checks, 0 while paused */
+guint
+fsguard_schedule_get_interval (FsGuardSchedule *schedule)
+{
+    return schedule->interval;
+}
+
+void
+fsguard_schedule_free (FsGuardSchedule *schedule)
+{
+    if (schedule->timeout != 0)
+        g_source_remove (schedule->timeout);
+    g_free (schedule);
+}
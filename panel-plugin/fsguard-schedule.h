@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __FSGUARD_SCHEDULE_H__
+#define __FSGUARD_SCHEDULE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _FsGuardSchedule FsGuardSchedule;
+
+/* Called for each check, from the main loop */
+typedef void (*FsGuardScheduleFunc) (gpointer user_data);
+
+FsGuardSchedule *fsguard_schedule_new          (guint                interval,
+                                                guint                interval_battery,
+                                                FsGuardScheduleFunc  func,
+                                                gpointer             user_data);
+void             fsguard_schedule_set_mapped   (FsGuardSchedule     *schedule,
+                                                gboolean             mapped);
+void             fsguard_schedule_set_session  (FsGuardSchedule     *schedule,
+                                                gboolean             idle,
+                                                gboolean             locked,
+                                                gboolean             on_battery);
+guint            fsguard_schedule_get_interval (FsGuardSchedule     *schedule);
+void             fsguard_schedule_free         (FsGuardSchedule     *schedule);
+
+G_END_DECLS
+
+#endif /* !__FSGUARD_SCHEDULE_H__ */
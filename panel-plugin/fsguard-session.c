@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <unistd.h>
+
+#include <gio/gio.h>
+#include <libxfce4util/libxfce4util.h>
+
+#include "fsguard-session.h"
+
+#define LOGIND_NAME             "org.freedesktop.login1"
+#define LOGIND_PATH             "/org/freedesktop/login1"
+#define LOGIND_MANAGER          "org.freedesktop.login1.Manager"
+#define LOGIND_SESSION          "org.freedesktop.login1.Session"
+#define UPOWER_NAME             "org.freedesktop.UPower"
+#define UPOWER_PATH             "/org/freedesktop/UPower"
+
+#define PROXY_FLAGS             (G_DBUS_PROXY_FLAGS_DO_NOT_CONNECT_SIGNALS \
+                                 | G_DBUS_PROXY_FLAGS_DO_NOT_AUTO_START)
+
+/*
+ * Follows the logind session of the panel and the power supply, both from
+ * the system bus, which is simply ignored when missing.
+ */
+struct _FsGuardSession
+{
+    FsGuardSessionFunc  func;
+    gpointer            user_data;
+    GCancellable       *cancellable;
+    GDBusProxy         *logind;
+    GDBusProxy         *upower;
+};
+
+static gboolean
+fsguard_session_get_boolean (GDBusProxy *proxy, const gchar *property)
+{
+    GVariant           *value;
+    gboolean            result = FALSE;
+
+    if (proxy == NULL)
+        return FALSE;
+
+    value = g_dbus_proxy_get_cached_property (proxy, property);
+    if (value != NULL) {
+        if (g_variant_is_of_type (value, G_VARIANT_TYPE_BOOLEAN))
+            result = g_variant_get_boolean (value);
+        g_variant_unref (value);
+    }
+
+    return result;
+}
+
+static void
+fsguard_session_changed (GDBusProxy *proxy, GVariant *changed,
+                         GStrv invalidated, FsGuardSession *session)
+{
+    session->func (fsguard_session_get_boolean (session->logind, "IdleHint"),
+                   fsguard_session_get_boolean (session->logind, "LockedHint"),
+                   fsguard_session_get_boolean (session->upower, "OnBattery"),
+                   session->user_data);
+}
+
+static void
+fsguard_session_proxy_ready (GObject *source_object, GAsyncResult *result, gpointer user_data)
+{
+    FsGuardSession     *session;
+    GDBusProxy         *proxy;
+    GError             *error = NULL;
+
+    proxy = g_dbus_proxy_new_finish (result, &error);
+    if (proxy == NULL) {
+        /* The session may be gone already when cancelled */
+        if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+            DBG ("No session information: %s", error->message);
+        g_error_free (error);
+        return;
+    }
+
+    session = user_data;
+    if (g_strcmp0 (g_dbus_proxy_get_interface_name (proxy), UPOWER_NAME) == 0)
+        session->upower = proxy;
+    else
+        session->logind = proxy;
+
+    g_signal_connect (proxy,
+                      "g-properties-changed",
+                      G_CALLBACK (fsguard_session_changed),
+                      session);
+    fsguard_session_changed (proxy, NULL, NULL, session);
+}
+
+static void
+fsguard_session_path_ready (GObject *source_object, GAsyncResult *result, gpointer user_data)
+{
+    FsGuardSession     *session;
+    GDBusConnection    *bus = G_DBUS_CONNECTION (source_object);
+    GVariant           *reply;
+    GError             *error = NULL;
+    const gchar        *path;
+
+    reply = g_dbus_connection_call_finish (bus, result, &error);
+    if (reply == NULL) {
+        if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+            DBG ("No logind session: %s", error->message);
+        g_error_free (error);
+        return;
+    }
+
+    session = user_data;
+    g_variant_get (reply, "(&o)", &path);
+    DBG ("Session %s", path);
+    g_dbus_proxy_new (bus, PROXY_FLAGS, NULL,
+                      LOGIND_NAME, path, LOGIND_SESSION,
+                      session->cancellable,
+                      fsguard_session_proxy_ready,
+                      session);
+    g_variant_unref (reply);
+}
+
+static void
+fsguard_session_bus_ready (GObject *source_object, GAsyncResult *result, gpointer user_data)
+{
+    FsGuardSession     *session;
+    GDBusConnection    *bus;
+    GError             *error = NULL;
+    const gchar        *id;
+
+    bus = g_bus_get_finish (result, &error);
+    if (bus == NULL) {
+        if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+            DBG ("No system bus: %s", error->message);
+        g_error_free (error);
+        return;
+    }
+
+    session = user_data;
+
+    /* Properties of session/auto can be read, but logind only signals
+     * changes on the real path of the session */
+    id = g_getenv ("XDG_SESSION_ID");
+    g_dbus_connection_call (bus, LOGIND_NAME, LOGIND_PATH, LOGIND_MANAGER,
+                            (id != NULL) ? "GetSession" : "GetSessionByPID",
+                            (id != NULL) ? g_variant_new ("(s)", id)
+                                         : g_variant_new ("(u)", (guint32) getpid ()),
+                            G_VARIANT_TYPE ("(o)"),
+                            G_DBUS_CALL_FLAGS_NO_AUTO_START, -1,
+                            session->cancellable,
+                            fsguard_session_path_ready,
+                            session);
+    g_dbus_proxy_new (bus, PROXY_FLAGS, NULL,
+                      UPOWER_NAME, UPOWER_PATH, UPOWER_NAME,
+                      session->cancellable,
+                      fsguard_session_proxy_ready,
+                      session);
+    g_object_unref (bus);
+}
+
+FsGuardSession *
+fsguard_session_new (FsGuardSessionFunc func, gpointer user_data)
+{
+    FsGuardSession *session = g_new0 (FsGuardSession, 1);
+
+    session->func = func;
+    session->user_data = user_data;
+    session->cancellable = g_cancellable_new ();
+
+    /* Honors DBUS_SYSTEM_BUS_ADDRESS */
+    g_bus_get (G_BUS_TYPE_SYSTEM, session->cancellable, fsguard_session_bus_ready, session);
+
+    return session;
+}
+
+void
+fsguard_session_free (FsGuardSession *session)
+{
+    g_cancellable_cancel (session->cancellable);
+    g_object_unref (session->cancellable);
+    if (session->logind != NULL) {
+        g_signal_handlers_disconnect_by_data (session->logind, session);
+        g_object_unref (session->logind);
+    }
+    if (session->upower != NULL) {
+        g_signal_handlers_disconnect_by_data (session->upower, session);
+        g_object_unref (session->upower);
+    }
+    g_free (session);
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __FSGUARD_TRACE_H__
+#define __FSGUARD_TRACE_H__
+
+#include <glib.h>
+
+/*
+ * Marks in the "fsguard" group of sysprof captures, tagged with the mount
+ * point, when built with -Dsysprof=enabled.  A phase is begun and ended
+ * within the same block:
+ *
+ *   FSGUARD_TRACE_BEGIN (statfs);
+ *   ...
+ *   FSGUARD_TRACE_END (statfs, path);
+ */
+
+#ifdef HAVE_SYSPROF
+
+#include <sysprof-capture.h>
+
+#define FSGUARD_TRACE_BEGIN(phase) \
+    gint64 fsguard_trace_##phase = SYSPROF_CAPTURE_CURRENT_TIME
+#define FSGUARD_TRACE_END(phase, path) \
+    sysprof_collector_mark (fsguard_trace_##phase, \
+                            SYSPROF_CAPTURE_CURRENT_TIME - fsguard_trace_##phase, \
+                            "fsguard", #phase, (path) != NULL ? (path) : "")
+
+#else
+
+#define FSGUARD_TRACE_BEGIN(phase)      G_STMT_START { } G_STMT_END
+#define FSGUARD_TRACE_END(phase, path)  G_STMT_START { } G_STMT_END
+
+#endif
+
+#endif /* !__FSGUARD_TRACE_H__ */
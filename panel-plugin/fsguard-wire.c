@@ -0,0 +1,408 @@
+/*
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+
+#include <gio/gunixsocketaddress.h>
+#include <libxfce4util/libxfce4util.h>
+
+#include "fsguard-wire.h"
+
+/* Peers not reading what they asked for are dropped */
+#define MAX_PENDING_OUTPUT      (1024 * 1024)
+
+struct _FsGuardChannel
+{
+    GSocketConnection  *connection;
+    GSocket            *socket;
+    GSource            *in_source;
+    GSource            *out_source;
+    guint               fail_id;
+    GByteArray         *in;
+    GByteArray         *out;
+
+    FsGuardChannelFrameFunc  frame_func;
+    FsGuardChannelClosedFunc closed_func;
+    gpointer            user_data;
+
+    /* the callbacks may free the channel, which is then deferred */
+    gboolean            dispatching;
+    gboolean            closed;
+    gboolean            freed;
+};
+
+static void
+fsguard_wire_put_varint (GByteArray *out, guint64 value)
+{
+    guint8 byte;
+
+    do {
+        byte = value & 0x7f;
+        value >>= 7;
+        if (value != 0)
+            byte |= 0x80;
+        g_byte_array_append (out, &byte, 1);
+    } while (value != 0);
+}
+
+static void
+fsguard_wire_put_svarint (GByteArray *out, gint64 value)
+{
+    fsguard_wire_put_varint (out, ((guint64) value << 1) ^ (guint64) (value >> 63));
+}
+
+gboolean
+fsguard_wire_get_varint (const guint8 **data, const guint8 *end, guint64 *value)
+{
+    const guint8       *p = *data;
+    guint64             result = 0;
+    guint               shift = 0;
+
+    while (p < end && shift < 64) {
+        result |= (guint64) (*p & 0x7f) << shift;
+        if (!(*p++ & 0x80)) {
+            *value = result;
+            *data = p;
+            return TRUE;
+        }
+        shift += 7;
+    }
+
+    return FALSE;
+}
+
+gboolean
+fsguard_wire_get_svarint (const guint8 **data, const guint8 *end, gint64 *value)
+{
+    guint64 raw;
+
+    if (!fsguard_wire_get_varint (data, end, &raw))
+        return FALSE;
+
+    *value = (gint64) (raw >> 1) ^ -(gint64) (raw & 1);
+    return TRUE;
+}
+
+static guint
+fsguard_wire_begin (GByteArray *out, guint8 type)
+{
+    guint8 header[3] = { 0x80, 0x00, type };
+    guint  offset = out->len;
+
+    g_byte_array_append (out, header, sizeof (header));
+
+    return offset;
+}
+
+static void
+fsguard_wire_end (GByteArray *out, guint offset)
+{
+    /* The length is a two byte varint, patched in once the payload is known */
+    guint len = out->len - offset - 2;
+
+    out->data[offset] = 0x80 | (len & 0x7f);
+    out->data[offset + 1] = (len >> 7) & 0x7f;
+}
+
+void
+fsguard_wire_put_subscribe (GByteArray *out, guint id, guint flags, const gchar *path)
+{
+    guint offset = fsguard_wire_begin (out, FSGUARD_WIRE_SUBSCRIBE);
+
+    fsguard_wire_put_varint (out, id);
+    fsguard_wire_put_varint (out, flags);
+    g_byte_array_append (out, (const guint8 *) path,
+                         MIN (strlen (path), (gsize) FSGUARD_WIRE_MAX_FRAME - 32));
+    fsguard_wire_end (out, offset);
+}
+
+void
+fsguard_wire_put_unsubscribe (GByteArray *out, guint id)
+{
+    guint offset = fsguard_wire_begin (out, FSGUARD_WIRE_UNSUBSCRIBE);
+
+    fsguard_wire_put_varint (out, id);
+    fsguard_wire_end (out, offset);
+}
+
+void
+fsguard_wire_put_sample (GByteArray *out, guint id, guint flags, gint status,
+                         gint64 total_delta, gint64 avail_delta)
+{
+    guint offset = fsguard_wire_begin (out, FSGUARD_WIRE_SAMPLE);
+
+    fsguard_wire_put_varint (out, id);
+    fsguard_wire_put_varint (out, flags);
+    fsguard_wire_put_varint (out, status);
+    fsguard_wire_put_svarint (out, total_delta);
+    fsguard_wire_put_svarint (out, avail_delta);
+    fsguard_wire_end (out, offset);
+}
+
+GSocketConnectable *
+fsguard_wire_parse_address (const gchar *address, GError **error)
+{
+    if (g_str_has_prefix (address, "unix:"))
+        return G_SOCKET_CONNECTABLE (g_unix_socket_address_new (address + strlen ("unix:")));
+
+    return g_network_address_parse (address, FSGUARD_AGENT_PORT, error);
+}
+
+static void
+fsguard_channel_finalize (FsGuardChannel *channel)
+{
+    g_byte_array_unref (channel->in);
+    g_byte_array_unref (channel->out);
+    g_object_unref (channel->connection);
+    g_free (channel);
+}
+
+static void
+fsguard_channel_stop (FsGuardChannel *channel)
+{
+    if (channel->in_source != NULL) {
+        g_source_destroy (channel->in_source);
+        g_source_unref (channel->in_source);
+        channel->in_source = NULL;
+    }
+    if (channel->out_source != NULL) {
+        g_source_destroy (channel->out_source);
+        g_source_unref (channel->out_source);
+        channel->out_source = NULL;
+    }
+    if (channel->fail_id != 0) {
+        g_source_remove (channel->fail_id);
+        channel->fail_id = 0;
+    }
+    if (!channel->closed)
+        g_io_stream_close (G_IO_STREAM (channel->connection), NULL, NULL);
+    channel->closed = TRUE;
+}
+
+static void
+fsguard_channel_close (FsGuardChannel *channel)
+{
+    gboolean dispatching = channel->dispatching;
+
+    if (channel->closed)
+        return;
+    fsguard_channel_stop (channel);
+
+    channel->dispatching = TRUE;
+    channel->closed_func (channel, channel->user_data);
+    channel->dispatching = dispatching;
+
+    if (!dispatching && channel->freed)
+        fsguard_channel_finalize (channel);
+}
+
+static gboolean
+fsguard_channel_failed (gpointer user_data)
+{
+    FsGuardChannel *channel = user_data;
+
+    channel->fail_id = 0;
+    fsguard_channel_close (channel);
+
+    return G_SOURCE_REMOVE;
+}
+
+static void
+fsguard_channel_fail (FsGuardChannel *channel)
+{
+    /* Not from within the caller, which may still use the channel */
+    if (channel->fail_id == 0)
+        channel->fail_id = g_idle_add (fsguard_channel_failed, channel);
+}
+
+static gboolean
+fsguard_channel_flush (FsGuardChannel *channel)
+{
+    GError             *error = NULL;
+    gssize              n;
+
+    while (channel->out->len > 0) {
+        n = g_socket_send (channel->socket, (const gchar *) channel->out->data,
+                           channel->out->len, NULL, &error);
+        if (n < 0) {
+            if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK)) {
+                g_error_free (error);
+                return TRUE;
+            }
+            DBG ("Unable to send: %s", error->message);
+            g_error_free (error);
+            return FALSE;
+        }
+        g_byte_array_remove_range (channel->out, 0, n);
+    }
+
+    return TRUE;
+}
+
+static gboolean
+fsguard_channel_writable (GSocket *socket, GIOCondition condition, gpointer user_data)
+{
+    FsGuardChannel *channel = user_data;
+
+    if (!fsguard_channel_flush (channel)) {
+        fsguard_channel_fail (channel);
+        return G_SOURCE_CONTINUE;
+    }
+    if (channel->out->len > 0)
+        return G_SOURCE_CONTINUE;
+
+    g_source_unref (channel->out_source);
+    channel->out_source = NULL;
+
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean
+fsguard_channel_readable (GSocket *socket, GIOCondition condition, gpointer user_data)
+{
+    FsGuardChannel     *channel = user_data;
+    const guint8       *p, *end, *frame;
+    guint8              buf[4096];
+    guint64             len;
+    GError             *error = NULL;
+    gssize              n;
+    gboolean            valid = TRUE;
+
+    n = g_socket_receive (socket, (gchar *) buf, sizeof (buf), NULL, &error);
+    if (n < 0 && g_error_matches (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK)) {
+        g_error_free (error);
+        return G_SOURCE_CONTINUE;
+    }
+
+    channel->dispatching = TRUE;
+
+    if (n <= 0) {
+        if (error != NULL) {
+            DBG ("Unable to receive: %s", error->message);
+            g_error_free (error);
+        }
+        fsguard_channel_close (channel);
+    } else {
+        g_byte_array_append (channel->in, buf, n);
+
+        p = channel->in->data;
+        end = p + channel->in->len;
+        while (p < end && !channel->closed) {
+            frame = p;
+            if (!fsguard_wire_get_varint (&frame, end, &len)) {
+                /* A truncated length is fine, an endless one is not */
+                valid = (end - p < 10);
+                break;
+            }
+            if (len == 0 || len > FSGUARD_WIRE_MAX_FRAME) {
+                valid = FALSE;
+                break;
+            }
+            if ((guint64) (end - frame) < len)
+                break;
+            if (!channel->frame_func (channel, frame, len, channel->user_data)) {
+                valid = FALSE;
+                break;
+            }
+            p = frame + len;
+        }
+
+        if (!valid)
+            fsguard_channel_close (channel);
+        else if (!channel->closed)
+            g_byte_array_remove_range (channel->in, 0, p - channel->in->data);
+    }
+
+    channel->dispatching = FALSE;
+    if (channel->freed) {
+        fsguard_channel_finalize (channel);
+        return G_SOURCE_REMOVE;
+    }
+
+    return channel->closed ? G_SOURCE_REMOVE : G_SOURCE_CONTINUE;
+}
+
+FsGuardChannel *
+fsguard_channel_new (GSocketConnection        *connection,
+                     FsGuardChannelFrameFunc   frame_func,
+                     FsGuardChannelClosedFunc  closed_func,
+                     gpointer                  user_data)
+{
+    FsGuardChannel *channel = g_new0 (FsGuardChannel, 1);
+
+    channel->connection = g_object_ref (connection);
+    channel->socket = g_socket_connection_get_socket (connection);
+    channel->in = g_byte_array_new ();
+    channel->out = g_byte_array_new ();
+    channel->frame_func = frame_func;
+    channel->closed_func = closed_func;
+    channel->user_data = user_data;
+
+    g_socket_set_blocking (channel->socket, FALSE);
+    channel->in_source = g_socket_create_source (channel->socket, G_IO_IN | G_IO_HUP | G_IO_ERR, NULL);
+    g_source_set_callback (channel->in_source, (GSourceFunc) (void (*)(void)) fsguard_channel_readable,
+                           channel, NULL);
+    g_source_attach (channel->in_source, NULL);
+
+    return channel;
+}
+
+void
+fsguard_channel_send (FsGuardChannel *channel, GByteArray *frames)
+{
+    if (channel->closed || frames->len == 0)
+        return;
+
+    g_byte_array_append (channel->out, frames->data, frames->len);
+    if (channel->out->len > MAX_PENDING_OUTPUT) {
+        fsguard_channel_fail (channel);
+        return;
+    }
+
+    /* Already waiting for the socket to become writable */
+    if (channel->out_source != NULL)
+        return;
+
+    if (!fsguard_channel_flush (channel)) {
+        fsguard_channel_fail (channel);
+    } else if (channel->out->len > 0) {
+        channel->out_source = g_socket_create_source (channel->socket, G_IO_OUT, NULL);
+        g_source_set_callback (channel->out_source, (GSourceFunc) (void (*)(void)) fsguard_channel_writable,
+                               channel, NULL);
+        g_source_attach (channel->out_source, NULL);
+    }
+}
+
+void
+fsguard_channel_free (FsGuardChannel *channel)
+{
+    fsguard_channel_stop (channel);
+
+    if (channel->dispatching)
+        channel->freed = TRUE;
+    else
+        fsguard_channel_finalize (channel);
+}
+
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __FSGUARD_WIRE_H__
+#define __FSGUARD_WIRE_H__
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Protocol between the plugin and xfce4-fsguard-agent.  Each frame is a
+ * varint payload length followed by the payload, whose first byte is the
+ * type of message and the rest a sequence of varints:
+ *
+ *   SUBSCRIBE    id, flags, path (rest of the payload)
+ *   UNSUBSCRIBE  id
+ *   SAMPLE       id, flags, status, total delta, avail delta
+ *
+ * The agent only sends a sample when it differs from the previous one sent
+ * for the same subscription; sizes are in bytes, sent as zigzag encoded
+ * differences from that previous sample (zero for the first one).
+ */
+
+#define FSGUARD_AGENT_PORT              7339
+#define FSGUARD_AGENT_SOCKET            "xfce4-fsguard-agent.socket"
+
+#define FSGUARD_WIRE_SUBSCRIBE          1
+#define FSGUARD_WIRE_UNSUBSCRIBE        2
+#define FSGUARD_WIRE_SAMPLE             3
+
+#define FSGUARD_WIRE_MOUNTED_ONLY       (1 << 0)
+#define FSGUARD_WIRE_MOUNT_CHANGED      (1 << 0)
+
+#define FSGUARD_WIRE_MAX_FRAME          8192
+
+typedef struct _FsGuardChannel FsGuardChannel;
+
+/* Returns FALSE on a malformed frame, which closes the channel */
+typedef gboolean (*FsGuardChannelFrameFunc)  (FsGuardChannel *channel,
+                                              const guint8   *payload,
+                                              gsize           len,
+                                              gpointer        user_data);
+/* The channel may be freed from there */
+typedef void     (*FsGuardChannelClosedFunc) (FsGuardChannel *channel,
+                                              gpointer        user_data);
+
+gboolean        fsguard_wire_get_varint     (const guint8       **data,
+                                             const guint8        *end,
+                                             guint64             *value);
+gboolean        fsguard_wire_get_svarint    (const guint8       **data,
+                                             const guint8        *end,
+                                             gint64              *value);
+
+void            fsguard_wire_put_subscribe  (GByteArray          *out,
+                                             guint                id,
+                                             guint                flags,
+                                             const gchar         *path);
+void            fsguard_wire_put_unsubscribe (GByteArray         *out,
+                                             guint                id);
+void            fsguard_wire_put_sample     (GByteArray          *out,
+                                             guint                id,
+                                             guint                flags,
+                                             gint                 status,
+                                             gint64               total_delta,
+                                             gint64               avail_delta);
+
+GSocketConnectable *fsguard_wire_parse_address (const gchar      *address,
+                                             GError             **error);
+
+FsGuardChannel *fsguard_channel_new         (GSocketConnection   *connection,
+                                             FsGuardChannelFrameFunc  frame_func,
+                                             FsGuardChannelClosedFunc closed_func,
+                                             gpointer             user_data);
+void            fsguard_channel_send        (FsGuardChannel      *channel,
+                                             GByteArray          *frames);
+void            fsguard_channel_free        (FsGuardChannel      *channel);
+
+G_END_DECLS
+
+#endif /* !__FSGUARD_WIRE_H__ */
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gio/gio.h>
+
+#include "fsguard-worker.h"
+
+/*
+ * Runs func on data in a worker thread, one run at a time, and hands data
+ * back to done in the main context.  A worker released while busy cannot
+ * stop the thread, it is left for the end of the run to free without
+ * calling done, so that its owner can go away right away.
+ */
+struct _FsGuardWorker
+{
+    FsGuardWorkerFunc       func;
+    FsGuardWorkerDoneFunc   done;
+    gpointer                user_data;
+    gboolean                released;
+    gboolean                busy;
+
+    /* owned by the worker thread while busy */
+    gpointer                data;
+    GDestroyNotify          data_free;
+};
+
+FsGuardWorker *
+fsguard_worker_new (FsGuardWorkerFunc      func,
+                    FsGuardWorkerDoneFunc  done,
+                    gpointer               user_data,
+                    gpointer               data,
+                    GDestroyNotify         data_free)
+{
+    FsGuardWorker *worker = g_new0 (FsGuardWorker, 1);
+
+    worker->func = func;
+    worker->done = done;
+    worker->user_data = user_data;
+    worker->data = data;
+    worker->data_free = data_free;
+
+    return worker;
+}
+
+static void
+fsguard_worker_free (FsGuardWorker *worker)
+{
+    if (worker->data_free != NULL)
+        worker->data_free (worker->data);
+    g_free (worker);
+}
+
+void
+fsguard_worker_release (FsGuardWorker *worker)
+{
+    /* Left for fsguard_worker_done() to free, done is not called anymore */
+    if (worker->busy)
+        worker->released = TRUE;
+    else
+        fsguard_worker_free (worker);
+}
+
+static void
+fsguard_worker_thread (GTask *task, gpointer source_object,
+                       gpointer task_data, GCancellable *cancellable)
+{
+    FsGuardWorker *worker = task_data;
+
+    worker->func (worker->data);
+    g_task_return_boolean (task, TRUE);
+}
+
+static void
+fsguard_worker_done (GObject *source_object, GAsyncResult *result, gpointer user_data)
+{
+    FsGuardWorker *worker = user_data;
+
+    worker->busy = FALSE;
+
+    if (worker->released) {
+        fsguard_worker_free (worker);
+        return;
+    }
+
+    /* Last, the worker may be gone once done returns */
+    worker->done (worker->data, worker->user_data);
+}
+
+/* FALSE when the previous run has not returned yet */
+gboolean
+fsguard_worker_run (FsGuardWorker *worker)
+{
+    GTask              *task;
+
+    if (worker->busy)
+        return FALSE;
+
+    worker->busy = TRUE;
+    task = g_task_new (NULL, NULL, fsguard_worker_done, worker);
+    g_task_set_task_data (task, worker, NULL);
+    g_task_run_in_thread (task, fsguard_worker_thread);
+    g_object_unref (task);
+
+    return TRUE;
+}
+
+gboolean
+fsguard_worker_is_busy (FsGuardWorker *worker)
+{
+    return worker->busy;
+}
+
+/* Not to be touched while busy */
+gpointer
+fsguard_worker_get_data (FsGuardWorker *worker)
+{
+    return worker->data;
+}
@@ -0,0 +1,294 @@
+/*
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "fsguard-writers.h"
+
+/* Must be a power of two */
+#define SLOTS_MIN               256
+/* Field of the start time in /proc/<pid>/stat, counting from 1 */
+#define STAT_STARTTIME          22
+
+/* Processes are tracked in an open addressing table indexed by pid, which
+ * is kept across samples along with the /proc directory stream: once the
+ * table has grown to the number of processes of the user, walking /proc
+ * does not allocate anymore. */
+typedef struct
+{
+    gint                pid;
+    guint               generation;
+    /* Tells a recycled pid apart from the process seen before */
+    guint64             starttime;
+    guint64             write_bytes;
+    gchar               comm[16];
+} FsGuardWriterSlot;
+
+struct _FsGuardWriters
+{
+    FsGuardWriterSlot  *slots;
+    FsGuardWriterSlot  *spare;
+    guint               size;
+    guint               used;
+    guint               generation;
+    gint64              timestamp;
+    uid_t               uid;
+    DIR                *proc;
+};
+
+FsGuardWriters *
+fsguard_writers_new (void)
+{
+    FsGuardWriters *writers = g_new0 (FsGuardWriters, 1);
+
+    writers->size = SLOTS_MIN;
+    writers->slots = g_new0 (FsGuardWriterSlot, SLOTS_MIN);
+    writers->spare = g_new0 (FsGuardWriterSlot, SLOTS_MIN);
+    writers->uid = getuid ();
+
+    return writers;
+}
+
+void
+fsguard_writers_free (FsGuardWriters *writers)
+{
+    if (writers->proc != NULL)
+        closedir (writers->proc);
+    g_free (writers->slots);
+    g_free (writers->spare);
+    g_free (writers);
+}
+
+void
+fsguard_writers_reset (FsGuardWriters *writers)
+{
+    /* The next sample only records the counters again */
+    writers->timestamp = 0;
+}
+
+static FsGuardWriterSlot *
+fsguard_writers_lookup (FsGuardWriters *writers, gint pid)
+{
+    guint mask = writers->size - 1;
+    guint i = ((guint) pid * 2654435761u) & mask;
+
+    while (writers->slots[i].pid != 0 && writers->slots[i].pid != pid)
+        i = (i + 1) & mask;
+
+    return &writers->slots[i];
+}
+
+static void
+fsguard_writers_rehash (FsGuardWriters *writers, guint size, guint max_age)
+{
+    FsGuardWriterSlot  *slots = writers->slots;
+    guint               old_size = writers->size;
+    guint               i;
+
+    if (size != old_size) {
+        g_free (writers->spare);
+        writers->spare = g_new0 (FsGuardWriterSlot, size);
+    } else {
+        memset (writers->spare, 0, size * sizeof (FsGuardWriterSlot));
+    }
+
+    writers->slots = writers->spare;
+    writers->size = size;
+    writers->used = 0;
+
+    for (i = 0; i < old_size; i++) {
+        if (slots[i].pid == 0 || writers->generation - slots[i].generation > max_age)
+            continue;
+        *fsguard_writers_lookup (writers, slots[i].pid) = slots[i];
+        writers->used++;
+    }
+
+    if (size != old_size) {
+        g_free (slots);
+        writers->spare = g_new (FsGuardWriterSlot, size);
+    } else {
+        writers->spare = slots;
+    }
+}
+
+static gboolean
+fsguard_writers_read (gint dir_fd, const gchar *path, gchar *buf, gsize size)
+{
+    gssize              len;
+    gint                fd;
+
+    fd = openat (dir_fd, path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        return FALSE;
+
+    len = read (fd, buf, size - 1);
+    close (fd);
+    if (len <= 0)
+        return FALSE;
+
+    buf[len] = '\0';
+    return TRUE;
+}
+
+/* The name can hold spaces and parentheses itself, it ends at the last
+ * ')' and is cut there in buf */
+static gboolean
+fsguard_writers_parse_stat (gchar *buf, const gchar **comm, guint64 *starttime)
+{
+    gchar              *start = strchr (buf, '(');
+    gchar              *end = strrchr (buf, ')');
+    gchar              *field;
+    guint               i;
+
+    if (start == NULL || end == NULL || end < start)
+        return FALSE;
+
+    /* Fields are separated by single spaces, the state after the name
+     * being field 3 */
+    field = end;
+    for (i = 2; i < STAT_STARTTIME && field != NULL; i++)
+        field = strchr (field + 1, ' ');
+    if (field == NULL)
+        return FALSE;
+
+    *end = '\0';
+    *comm = start + 1;
+    *starttime = g_ascii_strtoull (field + 1, NULL, 10);
+
+    return TRUE;
+}
+
+static guint
+fsguard_writers_rank (FsGuardWriter *top, guint n, guint n_top,
+                      const FsGuardWriterSlot *slot, guint64 rate)
+{
+    guint i;
+
+    if (n_top == 0 || (n == n_top && top[n - 1].rate >= rate))
+        return n;
+
+    for (i = MIN (n, n_top - 1); i > 0 && top[i - 1].rate < rate; i--)
+        top[i] = top[i - 1];
+
+    top[i].pid = slot->pid;
+    top[i].rate = rate;
+    memcpy (top[i].comm, slot->comm, sizeof (top[i].comm));
+
+    return MIN (n + 1, n_top);
+}
+
+/* Reads the io counters of every process, far too slow for the main loop */
+guint
+fsguard_writers_sample (FsGuardWriters *writers, FsGuardWriter *top, guint n_top)
+{
+    FsGuardWriterSlot  *slot;
+    struct dirent      *entry;
+    struct stat         st;
+    DIR                *proc;
+    gchar               path[32];
+    gchar               buf[512];
+    gchar              *value;
+    const gchar        *comm;
+    guint64             starttime;
+    guint64             write_bytes;
+    guint64             written;
+    gint64              now;
+    gint64              elapsed;
+    guint               seen = 0;
+    guint               n = 0;
+    gint                pid;
+
+    if (writers->proc == NULL)
+        writers->proc = opendir ("/proc");
+    else
+        rewinddir (writers->proc);
+    proc = writers->proc;
+    if (proc == NULL)
+        return 0;
+
+    now = g_get_monotonic_time ();
+    elapsed = (writers->timestamp > 0) ? now - writers->timestamp : 0;
+    writers->timestamp = now;
+    writers->generation++;
+
+    while ((entry = readdir (proc)) != NULL) {
+        if (!g_ascii_isdigit (entry->d_name[0]))
+            continue;
+        pid = atoi (entry->d_name);
+
+        /* The counters of other users are not readable anyway */
+        if (pid <= 0
+            || fstatat (dirfd (proc), entry->d_name, &st, 0) == -1
+            || st.st_uid != writers->uid)
+            continue;
+
+        g_snprintf (path, sizeof (path), "%d/io", pid);
+        if (!fsguard_writers_read (dirfd (proc), path, buf, sizeof (buf)))
+            continue;
+        value = strstr (buf, "\nwrite_bytes: ");
+        if (value == NULL)
+            continue;
+        write_bytes = g_ascii_strtoull (value + strlen ("\nwrite_bytes: "), NULL, 10);
+
+        g_snprintf (path, sizeof (path), "%d/stat", pid);
+        if (!fsguard_writers_read (dirfd (proc), path, buf, sizeof (buf))
+            || !fsguard_writers_parse_stat (buf, &comm, &starttime))
+            continue;
+
+        if ((writers->used + 1) * 2 > writers->size)
+            fsguard_writers_rehash (writers, writers->size * 2, 1);
+
+        slot = fsguard_writers_lookup (writers, pid);
+        if (slot->pid == 0 || slot->starttime != starttime) {
+            /* Started since the last sample, or a recycled pid */
+            if (slot->pid == 0)
+                writers->used++;
+            slot->pid = pid;
+            slot->starttime = starttime;
+            slot->write_bytes = 0;
+            g_strlcpy (slot->comm, comm, sizeof (slot->comm));
+        }
+
+        written = write_bytes - slot->write_bytes;
+        slot->write_bytes = write_bytes;
+        slot->generation = writers->generation;
+        seen++;
+
+        if (elapsed > 0 && written > 0)
+            n = fsguard_writers_rank (top, n, n_top, slot, written * G_USEC_PER_SEC / elapsed);
+    }
+
+    /* Forget about the processes which went away */
+    if (seen < writers->used)
+        fsguard_writers_rehash (writers, writers->size, 0);
+
+    return n;
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __FSGUARD_WRITERS_H__
+#define __FSGUARD_WRITERS_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+#define FSGUARD_WRITERS_TOP     3
+
+typedef struct _FsGuardWriters FsGuardWriters;
+
+typedef struct
+{
+    gint                pid;
+    gchar               comm[16];
+    guint64             rate;
+} FsGuardWriter;
+
+FsGuardWriters *fsguard_writers_new    (void);
+void            fsguard_writers_free   (FsGuardWriters *writers);
+void            fsguard_writers_reset  (FsGuardWriters *writers);
+guint           fsguard_writers_sample (FsGuardWriters *writers,
+                                        FsGuardWriter  *top,
+                                        guint           n_top);
+
+G_END_DECLS
+
+#endif /* !__FSGUARD_WRITERS_H__ */
@@ -38,25 +38,39 @@
 #include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
-#if defined(__linux__) || defined(__GNU__)
-#include <sys/vfs.h>
-#elif defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__) || defined(__FreeBSD_kernel__)
-#include <sys/param.h>
-#include <sys/mount.h>
-#endif
 
 #include <gtk/gtk.h>
 #include <libxfce4util/libxfce4util.h>
 #include <libxfce4ui/libxfce4ui.h>
 #include <libxfce4panel/libxfce4panel.h>
 
+#include "fsguard-check.h"
+#include "fsguard-deleted.h"
+#include "fsguard-probe.h"
+#include "fsguard-remote.h"
+#include "fsguard-schedule.h"
+#include "fsguard-session.h"
+#include "fsguard-trace.h"
+#include "fsguard-worker.h"
+#include "fsguard-writers.h"
+
 #define ICON_NORMAL             0
 #define ICON_WARNING            1
 #define ICON_URGENT             2
 #define ICON_INSENSITIVE        3
 
+#define PROBE_TIMEOUT           (4 * G_TIME_SPAN_SECOND)
+
+/* Bytes per second above which writers are sampled in any state */
+#define FILL_RATE_THRESHOLD     (1024 * 1024)
+
+#define HOLDERS_SHOWN           3
+
 #define BORDER                  8
 
+#define CHECK_INTERVAL          8192
+#define CHECK_INTERVAL_BATTERY  (4 * CHECK_INTERVAL)
+
 #define COLOR_NORMAL            "#00C000"
 #define COLOR_WARNING           "#FFE500"
 #define COLOR_URGENT            "#FF4F00"
@@ -65,22 +79,54 @@
 
 // struct {{{
 
+typedef struct _FsGuard FsGuard;
+
 typedef struct
+{
+    FsGuardWriters     *writers;
+    guint               n_top;
+    FsGuardWriter       top[FSGUARD_WRITERS_TOP];
+} FsGuardAttribution;
+
+typedef struct
+{
+    gchar              *path;
+    FsGuardDeleted     *deleted;
+} FsGuardScan;
+
+struct _FsGuard
 {
     XfcePanelPlugin    *plugin;
     GtkWidget          *settings_dialog;
     gboolean            seen;
     gint                icon_id;
     gchar              *css_class;
-    gint                timeout;
+    FsGuardSchedule    *schedule;
+    FsGuardSession     *session;
     guint               limit_warning;
     guint               limit_urgent;
     gboolean            show_size;
     gboolean            show_progress_bar;
     gboolean            hide_button;
     gboolean            show_name;
+    gboolean            mounted_only;
+    gboolean            attribute_writers;
     gchar              *name;
     gchar              *path;
+    gchar              *agent;
+    FsGuardCheck       *check;
+    FsGuardRemote      *remote;
+    gint                status;
+    guint64             total;
+    guint64             avail;
+    gint64              sampled;
+    gdouble             fill_rate;
+    FsGuardWorker      *attribution;
+    guint               n_writers;
+    FsGuardWriter       writers[FSGUARD_WRITERS_TOP];
+    FsGuardWorker      *scan;
+    FsGuardDeleted     *deleted;
+    gboolean            deleted_valid;
 
     GtkWidget          *ebox;
     GtkWidget          *box;
@@ -92,40 +138,13 @@ typedef struct
     GtkWidget          *pb_box;
     GtkWidget          *progress_bar;
     GtkWidget          *cb_hide_button;
-} FsGuard;
+    GtkWidget          *mi_find_deleted;
+};
 
 // }}}
 
 // all functions {{{
 
-static void
-fsguard_refresh_button (FsGuard *fsguard)
-{
-    /* Refresh the checkbox state as seen in the dialog */
-    if (fsguard->hide_button && (*(fsguard->name) == '\0' || !fsguard->show_name)
-        && !fsguard->show_size && !fsguard->show_progress_bar) {
-        DBG ("Show the button back");
-        if (G_LIKELY (GTK_IS_WIDGET (fsguard->cb_hide_button)))
-            gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (fsguard->cb_hide_button), TRUE);
-        else {
-            gtk_widget_show (fsguard->btn_panel);
-            fsguard->hide_button = FALSE;
-        }
-    }
-}
-
-static void
-fsguard_refresh_name (FsGuard *fsguard)
-{
-    if (*(fsguard->name) != '\0' && fsguard->show_name) {
-        gtk_label_set_text (GTK_LABEL(fsguard->lab_name), fsguard->name);
-        gtk_widget_show (fsguard->lab_name);
-    } else {
-        gtk_widget_hide (fsguard->lab_name);
-        fsguard_refresh_button (fsguard);
-    }
-}
-
 static void
 fsguard_set_icon (FsGuard *fsguard, gint id)
 {
@@ -141,6 +160,11 @@ fsguard_set_icon (FsGuard *fsguard, gint id)
 
     DBG ("icon id: new=%d, cur=%d", id, fsguard->icon_id);
     fsguard->icon_id = id;
+    /* Loaded once the button is displayed */
+    if (fsguard->icon_panel == NULL)
+        return;
+
+    FSGUARD_TRACE_BEGIN (icon_load);
     size = xfce_panel_plugin_get_size (fsguard->plugin);
     size /= xfce_panel_plugin_get_nrows (fsguard->plugin);
 
@@ -170,8 +194,12 @@ fsguard_set_icon (FsGuard *fsguard, gint id)
     pixbuf = scaled;
 
     surface = gdk_cairo_surface_create_from_pixbuf (pixbuf, scale_factor, NULL);
+    FSGUARD_TRACE_END (icon_load, fsguard->path);
+
+    FSGUARD_TRACE_BEGIN (icon);
     gtk_image_set_from_surface (GTK_IMAGE (fsguard->icon_panel), surface);
     gtk_widget_set_sensitive (fsguard->icon_panel, id != ICON_INSENSITIVE);
+    FSGUARD_TRACE_END (icon, fsguard->path);
     cairo_surface_destroy (surface);
     g_object_unref (G_OBJECT (pixbuf));
 }
@@ -205,74 +233,366 @@ fsguard_refresh_monitor_color (FsGuard *fsguard, gchar *css_class)
     }
 
     DBG("removing class %s, adding %s", fsguard->css_class, css_class);
-    gtk_style_context_remove_class (
-        GTK_STYLE_CONTEXT(gtk_widget_get_style_context (GTK_WIDGET (fsguard->progress_bar))),
-        fsguard->css_class);
-    gtk_style_context_add_class (
-        GTK_STYLE_CONTEXT(gtk_widget_get_style_context (GTK_WIDGET (fsguard->progress_bar))),
-        css_class);
+    if (fsguard->progress_bar != NULL) {
+        gtk_style_context_remove_class (
+            GTK_STYLE_CONTEXT(gtk_widget_get_style_context (GTK_WIDGET (fsguard->progress_bar))),
+            fsguard->css_class);
+        gtk_style_context_add_class (
+            GTK_STYLE_CONTEXT(gtk_widget_get_style_context (GTK_WIDGET (fsguard->progress_bar))),
+            css_class);
+    }
     g_free(fsguard->css_class);
     fsguard->css_class = g_strdup(css_class);
 }
 
-static inline gboolean
-__open_mnt (gchar *command, gchar *path)
+typedef struct
+{
+    gchar              *uri;
+    GAppLaunchContext  *context;
+    guint               index;
+} FsGuardLaunch;
+
+static const gchar *fsguard_launchers[] = {
+#if LIBXFCE4UI_CHECK_VERSION(4, 21, 0)
+    "xfce-open",
+#else
+    "exo-open",
+#endif
+    "Thunar",
+    "xdg-open",
+};
+
+/* Shared by all instances, only looked up again when launching fails */
+static GAppInfo        *fsguard_launcher = NULL;
+static guint            fsguard_launcher_index = 0;
+
+static GAppInfo *
+fsguard_resolve_launcher (guint first, guint *index)
+{
+    GAppInfo           *app_info;
+    gchar              *program;
+    gchar              *quoted;
+    guint               i;
+
+    for (i = first; i < G_N_ELEMENTS (fsguard_launchers); i++) {
+        program = g_find_program_in_path (fsguard_launchers[i]);
+        if (program == NULL)
+            continue;
+
+        quoted = g_shell_quote (program);
+        app_info = g_app_info_create_from_commandline (quoted, fsguard_launchers[i],
+                                                       G_APP_INFO_CREATE_SUPPORTS_STARTUP_NOTIFICATION,
+                                                       NULL);
+        g_free (quoted);
+        g_free (program);
+
+        if (app_info != NULL) {
+            DBG ("Open mount points with `%s'", fsguard_launchers[i]);
+            *index = i;
+            return app_info;
+        }
+    }
+
+    return NULL;
+}
+
+static void
+fsguard_launch_free (FsGuardLaunch *launch)
 {
-    gboolean res;
-    gchar *cmd;
-    gchar *path_quoted;
-    path_quoted = g_shell_quote (path);
-    cmd = g_strdup_printf ("%s %s", command, path_quoted);
-    res = xfce_spawn_command_line (NULL, cmd, FALSE, FALSE, TRUE, NULL);
-    g_free (path_quoted);
-    g_free (cmd);
-    return res;
+    g_object_unref (launch->context);
+    g_free (launch->uri);
+    g_free (launch);
 }
 
 static void
-fsguard_open_mnt (GtkWidget *widget, FsGuard *fsguard)
+fsguard_launch_error (void)
 {
     GtkWidget *dialog;
 
-    if (fsguard->path == NULL || fsguard->path[0] == '\0')
-      return;
-
-#if LIBXFCE4UI_CHECK_VERSION(4, 21, 0)
-    if (__open_mnt ("xfce-open", fsguard->path))
-#else
-    if (__open_mnt ("exo-open", fsguard->path))
-#endif
-      return;
-    if (__open_mnt ("Thunar", fsguard->path))
-      return;
-    if (__open_mnt ("xdg-open", fsguard->path))
-      return;
-
     dialog = gtk_message_dialog_new (NULL, 0, GTK_MESSAGE_ERROR, GTK_BUTTONS_CLOSE,
-                                     "Free Space Checker");
+                                     _("Free Space Checker"));
     gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (dialog),
                                               _("Unable to find an appropriate application to open the mount point"));
+    gtk_window_set_icon_name (GTK_WINDOW (dialog), "xfce4-fsguard-plugin");
+    g_signal_connect (dialog, "response", G_CALLBACK (gtk_widget_destroy), NULL);
+    gtk_widget_show (dialog);
 }
 
+static void fsguard_launch (FsGuardLaunch *launch);
+
 static void
-fsguard_check_fs (FsGuard *fsguard)
+fsguard_launch_done (GObject *source_object, GAsyncResult *result, gpointer user_data)
+{
+    FsGuardLaunch      *launch = user_data;
+    GError             *error = NULL;
+
+    if (g_app_info_launch_uris_finish (G_APP_INFO (source_object), result, &error)) {
+        fsguard_launch_free (launch);
+        return;
+    }
+
+    g_warning ("Unable to open %s with %s: %s", launch->uri,
+               fsguard_launchers[launch->index], error->message);
+    g_error_free (error);
+
+    /* Fall back to the next launcher, unless another launch already did */
+    if (fsguard_launcher == G_APP_INFO (source_object)) {
+        g_clear_object (&fsguard_launcher);
+        fsguard_launcher = fsguard_resolve_launcher (launch->index + 1, &fsguard_launcher_index);
+    }
+
+    if (fsguard_launcher != NULL && fsguard_launcher_index > launch->index) {
+        fsguard_launch (launch);
+    } else {
+        fsguard_launch_error ();
+        fsguard_launch_free (launch);
+    }
+}
+
+static void
+fsguard_launch (FsGuardLaunch *launch)
+{
+    GList               uris = { launch->uri, NULL, NULL };
+
+    launch->index = fsguard_launcher_index;
+    g_app_info_launch_uris_async (fsguard_launcher, &uris, launch->context,
+                                  NULL, fsguard_launch_done, launch);
+}
+
+static void
+fsguard_open_mnt (GtkWidget *widget, FsGuard *fsguard)
+{
+    FsGuardLaunch      *launch;
+    GdkAppLaunchContext *context;
+    GFile              *file;
+
+    if (fsguard->path == NULL || fsguard->path[0] == '\0' || *(fsguard->agent) != '\0')
+      return;
+
+    if (fsguard_launcher == NULL)
+        fsguard_launcher = fsguard_resolve_launcher (0, &fsguard_launcher_index);
+    if (fsguard_launcher == NULL) {
+        fsguard_launch_error ();
+        return;
+    }
+
+    context = gdk_display_get_app_launch_context (gtk_widget_get_display (widget));
+    gdk_app_launch_context_set_screen (context, gtk_widget_get_screen (widget));
+    gdk_app_launch_context_set_timestamp (context, gtk_get_current_event_time ());
+
+    file = g_file_new_for_path (fsguard->path);
+    launch = g_new0 (FsGuardLaunch, 1);
+    launch->uri = g_file_get_uri (file);
+    launch->context = G_APP_LAUNCH_CONTEXT (context);
+    g_object_unref (file);
+
+    fsguard_launch (launch);
+}
+
+/* Shared by the progress bars of all instances */
+static GtkCssProvider  *fsguard_css_provider = NULL;
+
+static void
+fsguard_layout_labels (FsGuard *fsguard)
+{
+    gboolean vertical = (xfce_panel_plugin_get_mode (fsguard->plugin) == XFCE_PANEL_PLUGIN_MODE_VERTICAL);
+
+    if (fsguard->lab_name != NULL)
+        gtk_label_set_angle (GTK_LABEL(fsguard->lab_name), vertical ? -90 : 0);
+    if (fsguard->lab_size != NULL)
+        gtk_label_set_angle (GTK_LABEL(fsguard->lab_size), vertical ? -90 : 0);
+    gtk_orientable_set_orientation (GTK_ORIENTABLE (fsguard->lab_box),
+                                    vertical ? GTK_ORIENTATION_HORIZONTAL : GTK_ORIENTATION_VERTICAL);
+    if (fsguard->lab_name != NULL && fsguard->lab_size != NULL)
+        gtk_box_reorder_child (GTK_BOX (fsguard->lab_box),
+                               vertical ? fsguard->lab_size : fsguard->lab_name, 0);
+
+    /* Keep the spacing of the box for displayed labels only */
+    gtk_widget_set_visible (fsguard->lab_box, fsguard->lab_name != NULL || fsguard->lab_size != NULL);
+}
+
+static void
+fsguard_layout_progress_bar (FsGuard *fsguard)
+{
+    GtkOrientation orientation = xfce_panel_plugin_get_orientation (fsguard->plugin);
+    gint size = xfce_panel_plugin_get_size (fsguard->plugin);
+
+    if (fsguard->pb_box == NULL)
+        return;
+
+    gtk_orientable_set_orientation (GTK_ORIENTABLE (fsguard->pb_box), orientation);
+    gtk_orientable_set_orientation (GTK_ORIENTABLE (fsguard->progress_bar), !orientation);
+    gtk_progress_bar_set_inverted (GTK_PROGRESS_BAR(fsguard->progress_bar), (orientation == GTK_ORIENTATION_HORIZONTAL));
+    gtk_container_set_border_width (GTK_CONTAINER (fsguard->pb_box), (size > 26 ? 2 : 1));
+    if (orientation == GTK_ORIENTATION_HORIZONTAL)
+        gtk_widget_set_size_request (GTK_WIDGET(fsguard->progress_bar), 8, -1);
+    else
+        gtk_widget_set_size_request (GTK_WIDGET(fsguard->progress_bar), -1, 8);
+}
+
+static void
+fsguard_layout_button (FsGuard *fsguard)
+{
+    gint size = xfce_panel_plugin_get_size (fsguard->plugin);
+    gint border_width = (size > 26 ? 2 : 1);
+
+    if (fsguard->btn_panel == NULL)
+        return;
+
+    size /= xfce_panel_plugin_get_nrows (fsguard->plugin);
+    gtk_widget_set_size_request (fsguard->btn_panel, size, size);
+    size -= 2 * border_width;
+    gtk_widget_set_size_request (fsguard->icon_panel, size, size);
+}
+
+/* The widgets below are only created while displayed */
+static void
+fsguard_refresh_btn_panel (FsGuard *fsguard)
+{
+    if (fsguard->hide_button) {
+        if (fsguard->btn_panel != NULL) {
+            gtk_widget_destroy (fsguard->btn_panel);
+            fsguard->btn_panel = NULL;
+            fsguard->icon_panel = NULL;
+        }
+        return;
+    }
+    if (fsguard->btn_panel != NULL)
+        return;
+
+    fsguard->btn_panel = xfce_panel_create_button ();
+    fsguard->icon_panel = gtk_image_new ();
+    g_signal_connect (G_OBJECT(fsguard->btn_panel),
+                      "clicked",
+                      G_CALLBACK(fsguard_open_mnt),
+                      fsguard);
+    gtk_container_add (GTK_CONTAINER(fsguard->btn_panel), fsguard->icon_panel);
+    gtk_container_add (GTK_CONTAINER(fsguard->box), fsguard->btn_panel);
+    gtk_box_reorder_child (GTK_BOX (fsguard->box), fsguard->btn_panel, 0);
+    xfce_panel_plugin_add_action_widget (fsguard->plugin, fsguard->btn_panel);
+    fsguard_layout_button (fsguard);
+    gtk_widget_show_all (fsguard->btn_panel);
+}
+
+static void
+fsguard_refresh_button (FsGuard *fsguard)
+{
+    /* Refresh the checkbox state as seen in the dialog */
+    if (fsguard->hide_button && (*(fsguard->name) == '\0' || !fsguard->show_name)
+        && !fsguard->show_size && !fsguard->show_progress_bar) {
+        DBG ("Show the button back");
+        if (G_LIKELY (GTK_IS_WIDGET (fsguard->cb_hide_button)))
+            gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (fsguard->cb_hide_button), TRUE);
+        else {
+            fsguard->hide_button = FALSE;
+            fsguard_refresh_btn_panel (fsguard);
+            fsguard_refresh_icon (fsguard);
+        }
+    }
+}
+
+static void
+fsguard_refresh_name (FsGuard *fsguard)
+{
+    if (*(fsguard->name) != '\0' && fsguard->show_name) {
+        if (fsguard->lab_name == NULL) {
+            fsguard->lab_name = gtk_label_new (NULL);
+            gtk_container_add (GTK_CONTAINER(fsguard->lab_box), fsguard->lab_name);
+            gtk_widget_show (fsguard->lab_name);
+            fsguard_layout_labels (fsguard);
+        }
+        gtk_label_set_text (GTK_LABEL(fsguard->lab_name), fsguard->name);
+    } else {
+        if (fsguard->lab_name != NULL) {
+            gtk_widget_destroy (fsguard->lab_name);
+            fsguard->lab_name = NULL;
+            fsguard_layout_labels (fsguard);
+        }
+        fsguard_refresh_button (fsguard);
+    }
+}
+
+static void
+fsguard_refresh_lab_size (FsGuard *fsguard)
+{
+    if (!fsguard->show_size) {
+        if (fsguard->lab_size != NULL) {
+            gtk_widget_destroy (fsguard->lab_size);
+            fsguard->lab_size = NULL;
+            fsguard_layout_labels (fsguard);
+        }
+        return;
+    }
+    if (fsguard->lab_size != NULL)
+        return;
+
+    fsguard->lab_size = gtk_label_new (NULL);
+    gtk_container_add (GTK_CONTAINER(fsguard->lab_box), fsguard->lab_size);
+    gtk_widget_show (fsguard->lab_size);
+    fsguard_layout_labels (fsguard);
+}
+
+static void
+fsguard_refresh_progress_bar (FsGuard *fsguard)
+{
+    if (!fsguard->show_progress_bar) {
+        if (fsguard->pb_box != NULL) {
+            gtk_widget_destroy (fsguard->pb_box);
+            fsguard->pb_box = NULL;
+            fsguard->progress_bar = NULL;
+        }
+        return;
+    }
+    if (fsguard->pb_box != NULL)
+        return;
+
+    if (fsguard_css_provider == NULL) {
+        fsguard_css_provider = gtk_css_provider_new ();
+        gtk_css_provider_load_from_data (fsguard_css_provider, "\
+            progressbar.horizontal trough { min-height: 4px; }\
+            progressbar.horizontal progress { min-height: 4px; }\
+            progressbar.vertical trough { min-width: 4px; }\
+            progressbar.vertical progress { min-width: 4px; }\
+            .normal progress { background-color: " COLOR_NORMAL " ; background-image: none; }\
+            .warning progress { background-color: " COLOR_WARNING " ; background-image: none; }\
+            .urgent progress { background-color: " COLOR_URGENT " ; background-image: none; }",
+             -1, NULL);
+    }
+
+    fsguard->progress_bar = gtk_progress_bar_new ();
+    gtk_style_context_add_provider (
+        GTK_STYLE_CONTEXT (gtk_widget_get_style_context (GTK_WIDGET (fsguard->progress_bar))),
+        GTK_STYLE_PROVIDER (fsguard_css_provider),
+        GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
+    gtk_style_context_add_class (
+        GTK_STYLE_CONTEXT(gtk_widget_get_style_context (GTK_WIDGET (fsguard->progress_bar))),
+        fsguard->css_class);
+    gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR(fsguard->progress_bar), 0.0);
+    fsguard->pb_box = gtk_box_new (xfce_panel_plugin_get_orientation (fsguard->plugin), 0);
+    gtk_container_add (GTK_CONTAINER(fsguard->pb_box), fsguard->progress_bar);
+    gtk_container_add (GTK_CONTAINER(fsguard->box), fsguard->pb_box);
+    fsguard_layout_progress_bar (fsguard);
+    gtk_widget_show_all (fsguard->pb_box);
+}
+
+static void
+fsguard_update (FsGuard *fsguard)
 {
     float               freespace = 0;
     float               total = 0;
-    int                 err;
+    gint                status = fsguard->status;
     gchar              *css_class = "normal";
     gchar               msg_size[100], msg_total_size[100], msg[100];
     gint                icon_id = ICON_INSENSITIVE;
-    static struct statfs fsd;
-
-    err = statfs (fsguard->path, &fsd);
+    FsGuardHolder      *holder;
+    GString            *tooltip;
+    gchar              *size;
+    guint               i;
 
-    if (err != -1) {
-        long blocksize = fsd.f_bsize;
-        float freeblocks = fsd.f_bavail;
-        float totalblocks = fsd.f_blocks;
-        freespace = (freeblocks * blocksize) / 1048576;
-        total = (totalblocks * blocksize) / 1048576;
+    FSGUARD_TRACE_BEGIN (evaluate);
+    if (status == FSGUARD_PROBE_OK) {
+        freespace = (float) fsguard->avail / 1048576;
+        total = (float) fsguard->total / 1048576;
 
         if (freespace > (total * fsguard->limit_warning / 100)) {
             icon_id = ICON_NORMAL;
@@ -285,6 +605,14 @@ fsguard_check_fs (FsGuard *fsguard)
             css_class = "urgent";
         }
     }
+    FSGUARD_TRACE_END (evaluate, fsguard->path);
+
+    FSGUARD_TRACE_BEGIN (format);
+    if (status == FSGUARD_PROBE_NOT_MOUNTED)
+        g_snprintf (msg, sizeof (msg), _("%s is not mounted"), fsguard->path);
+    else if (status == FSGUARD_PROBE_HUNG)
+        g_snprintf (msg, sizeof (msg), _("%s is not responding"), fsguard->path);
+    else
         g_snprintf (msg, sizeof (msg),
                     _("could not check mountpoint %s, please check your config"),
                     fsguard->path);
@@ -297,27 +625,69 @@ fsguard_check_fs (FsGuard *fsguard)
         g_snprintf (msg_total_size, sizeof (msg_total_size), _("%.0f MB"), total);
         g_snprintf (msg_size, sizeof (msg_size), _("%.0f MB"), freespace);
     }
-    if (err != -1)
+    if (status == FSGUARD_PROBE_OK)
         g_snprintf (msg, sizeof (msg),
                     (*(fsguard->name) != '\0' && strcmp(fsguard->path, fsguard->name)) ?
                     _("%s/%s space left on %s (%s)") : _("%s/%s space left on %s"),
                     msg_size, msg_total_size, fsguard->path, fsguard->name);
+    FSGUARD_TRACE_END (format, fsguard->path);
 
-    if (fsguard->show_size) {
+    if (fsguard->lab_size != NULL) {
+        FSGUARD_TRACE_BEGIN (label);
         gtk_label_set_text (GTK_LABEL(fsguard->lab_size),
                             msg_size);
+        FSGUARD_TRACE_END (label, fsguard->path);
     }
-    if (fsguard->show_progress_bar) {
+    if (fsguard->progress_bar != NULL) {
+        FSGUARD_TRACE_BEGIN (progress_bar);
         gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR(fsguard->progress_bar),
                                        (total > 0 ) ? 1.0 - (freespace / total) : 0.0);
-        if (icon_id != fsguard->icon_id)
-            fsguard_refresh_monitor_color (fsguard, css_class);
+        FSGUARD_TRACE_END (progress_bar, fsguard->path);
+    }
+    if (icon_id != fsguard->icon_id) {
+        FSGUARD_TRACE_BEGIN (color);
+        fsguard_refresh_monitor_color (fsguard, css_class);
+        FSGUARD_TRACE_END (color, fsguard->path);
+    }
+
+    FSGUARD_TRACE_BEGIN (format_tooltip);
+    tooltip = g_string_new (msg);
+    if (fsguard->n_writers > 0) {
+        g_string_append_printf (tooltip, "\n%s", _("Top writers:"));
+        for (i = 0; i < fsguard->n_writers; i++) {
+            size = g_format_size (fsguard->writers[i].rate);
+            g_string_append_c (tooltip, '\n');
+            g_string_append_printf (tooltip, _("%s (%d): %s/s"),
+                                    fsguard->writers[i].comm, fsguard->writers[i].pid, size);
+            g_free (size);
+        }
+    }
+    if (fsguard->deleted != NULL) {
+        g_string_append_c (tooltip, '\n');
+        if (fsguard->deleted->n_files == 0) {
+            g_string_append (tooltip, _("No space held by deleted files"));
+        } else {
+            size = g_format_size (fsguard->deleted->size);
+            g_string_append_printf (tooltip, _("%s held by deleted files:"), size);
+            g_free (size);
+            for (i = 0; i < MIN (fsguard->deleted->holders->len, HOLDERS_SHOWN); i++) {
+                holder = &g_array_index (fsguard->deleted->holders, FsGuardHolder, i);
+                size = g_format_size (holder->size);
+                g_string_append_c (tooltip, '\n');
+                g_string_append_printf (tooltip, _("%s (%d): %s"), holder->comm, holder->pid, size);
+                g_free (size);
+            }
+        }
     }
+    FSGUARD_TRACE_END (format_tooltip, fsguard->path);
 
-    gtk_widget_set_tooltip_text(fsguard->ebox, msg);
+    FSGUARD_TRACE_BEGIN (tooltip);
+    gtk_widget_set_tooltip_text (fsguard->ebox, tooltip->str);
+    FSGUARD_TRACE_END (tooltip, fsguard->path);
+    g_string_free (tooltip, TRUE);
     fsguard_set_icon (fsguard, icon_id);
 
-    if (err != -1 && !fsguard->seen && icon_id == ICON_URGENT) {
+    if (status == FSGUARD_PROBE_OK && !fsguard->seen && icon_id == ICON_URGENT) {
         fsguard->seen = TRUE;
         if (*(fsguard->name) != '\0' && strcmp(fsguard->path, fsguard->name) != 0) {
             xfce_dialog_show_warning (NULL, NULL, _("Only %s space left on %s (%s)!"),
@@ -329,13 +699,260 @@ fsguard_check_fs (FsGuard *fsguard)
     }
 }
 
+static FsGuardAttribution *
+fsguard_attribution_new (void)
+{
+    FsGuardAttribution *attribution = g_new0 (FsGuardAttribution, 1);
+
+    attribution->writers = fsguard_writers_new ();
+
+    return attribution;
+}
+
+static void
+fsguard_attribution_free (FsGuardAttribution *attribution)
+{
+    fsguard_writers_free (attribution->writers);
+    g_free (attribution);
+}
+
+static void
+fsguard_attribution_release (FsGuard *fsguard)
+{
+    if (fsguard->attribution != NULL) {
+        fsguard_worker_release (fsguard->attribution);
+        fsguard->attribution = NULL;
+    }
+}
+
+static void
+fsguard_attribution_run (gpointer data)
+{
+    FsGuardAttribution *attribution = data;
+
+    attribution->n_top = fsguard_writers_sample (attribution->writers, attribution->top,
+                                                 FSGUARD_WRITERS_TOP);
+}
+
+static void
+fsguard_attribution_done (gpointer data, gpointer user_data)
+{
+    FsGuardAttribution *attribution = data;
+    FsGuard            *fsguard = user_data;
+
+    fsguard->n_writers = attribution->n_top;
+    memcpy (fsguard->writers, attribution->top, sizeof (fsguard->writers));
+    fsguard_update (fsguard);
+}
+
+static void
+fsguard_attribute (FsGuard *fsguard)
+{
+    FsGuardAttribution *attribution;
+
+    /* Only look for the culprits while the mount point is filling up */
+    if (!fsguard->attribute_writers || fsguard->status != FSGUARD_PROBE_OK
+        || (fsguard->icon_id == ICON_NORMAL && fsguard->fill_rate < FILL_RATE_THRESHOLD)) {
+        if (fsguard->attribution != NULL && !fsguard_worker_is_busy (fsguard->attribution)) {
+            attribution = fsguard_worker_get_data (fsguard->attribution);
+            fsguard_writers_reset (attribution->writers);
+        }
+        if (fsguard->n_writers > 0) {
+            fsguard->n_writers = 0;
+            fsguard_update (fsguard);
+        }
+        return;
+    }
+
+    if (fsguard->attribution == NULL)
+        fsguard->attribution = fsguard_worker_new (fsguard_attribution_run,
+                                                   fsguard_attribution_done, fsguard,
+                                                   fsguard_attribution_new (),
+                                                   (GDestroyNotify) fsguard_attribution_free);
+    fsguard_worker_run (fsguard->attribution);
+}
+
+static void
+fsguard_scan_free (FsGuardScan *scan)
+{
+    if (scan->deleted != NULL)
+        fsguard_deleted_free (scan->deleted);
+    g_free (scan->path);
+    g_free (scan);
+}
+
+static void
+fsguard_scan_run (gpointer data)
+{
+    FsGuardScan *scan = data;
+
+    scan->deleted = fsguard_deleted_scan (scan->path);
+}
+
+static void
+fsguard_scan_done (gpointer data, gpointer user_data)
+{
+    FsGuardScan        *scan = data;
+    FsGuard            *fsguard = user_data;
+
+    fsguard->deleted = scan->deleted;
+    fsguard->deleted_valid = TRUE;
+    scan->deleted = NULL;
+
+    fsguard_worker_release (fsguard->scan);
+    fsguard->scan = NULL;
+    fsguard_update (fsguard);
+}
+
+static void
+fsguard_find_deleted (FsGuard *fsguard)
+{
+    FsGuardScan        *scan;
+
+    if (fsguard->remote != NULL || fsguard->scan != NULL || fsguard->status != FSGUARD_PROBE_OK)
+        return;
+
+    scan = g_new0 (FsGuardScan, 1);
+    scan->path = g_strdup (fsguard->path);
+    fsguard->scan = fsguard_worker_new (fsguard_scan_run, fsguard_scan_done, fsguard,
+                                        scan, (GDestroyNotify) fsguard_scan_free);
+    fsguard_worker_run (fsguard->scan);
+}
+
 static gboolean
+fsguard_forget_deleted (FsGuard *fsguard)
+{
+    gboolean shown = (fsguard->deleted != NULL);
+
+    if (fsguard->scan != NULL) {
+        /* Dropped, the state changed in the meantime */
+        fsguard_worker_release (fsguard->scan);
+        fsguard->scan = NULL;
+    }
+    if (fsguard->deleted != NULL) {
+        fsguard_deleted_free (fsguard->deleted);
+        fsguard->deleted = NULL;
+    }
+    fsguard->deleted_valid = FALSE;
+
+    return shown;
+}
+
+static void
+fsguard_find_deleted_cb (GtkMenuItem *item, FsGuard *fsguard)
+{
+    fsguard_forget_deleted (fsguard);
+    fsguard_find_deleted (fsguard);
+}
+
+static void
+fsguard_set_sample (FsGuard *fsguard, gint status, guint64 total, guint64 avail,
+                    gboolean mnt_changed)
+{
+    gint64              now;
+    gint                icon_id;
+
+    if (mnt_changed) {
+        fsguard->seen = FALSE;
+        fsguard->sampled = 0;
+    }
+
+    if (status == FSGUARD_PROBE_OK) {
+        now = g_get_monotonic_time ();
+        fsguard->fill_rate = 0;
+        if (fsguard->sampled > 0 && avail < fsguard->avail)
+            fsguard->fill_rate = (gdouble) (fsguard->avail - avail)
+                                 * G_USEC_PER_SEC / (now - fsguard->sampled);
+        fsguard->sampled = now;
+    } else {
+        fsguard->sampled = 0;
+    }
+
+    fsguard->status = status;
+    fsguard->total = total;
+    fsguard->avail = avail;
+
+    icon_id = fsguard->icon_id;
+    fsguard_update (fsguard);
+
+    /* Processes of a remote host cannot be looked at */
+    if (fsguard->remote != NULL)
+        return;
+
+    /* Deleted files are only looked for again once the state changed */
+    if ((mnt_changed || fsguard->icon_id != icon_id) && fsguard_forget_deleted (fsguard))
+        fsguard_update (fsguard);
+    if (fsguard->icon_id == ICON_URGENT && !fsguard->deleted_valid)
+        fsguard_find_deleted (fsguard);
+
+    fsguard_attribute (fsguard);
+}
+
+static void
+fsguard_sample (gint status, guint64 total, guint64 avail,
+                gboolean mnt_changed, gpointer user_data)
+{
+    fsguard_set_sample (user_data, status, total, avail, mnt_changed);
+}
+
+static void
+fsguard_check_fs (FsGuard *fsguard)
+{
+    /* The agent sends samples on its own */
+    if (fsguard->remote == NULL)
+        fsguard_check_run (fsguard->check, fsguard->mounted_only);
+}
+
+static void
+fsguard_watch (FsGuard *fsguard)
+{
+    if (*(fsguard->agent) != '\0')
+        fsguard->remote = fsguard_remote_subscribe (fsguard->agent, fsguard->path,
+                                                    fsguard->mounted_only,
+                                                    fsguard_sample, fsguard);
+    else
+        fsguard->check = fsguard_check_new (fsguard->path, PROBE_TIMEOUT,
+                                            fsguard_sample, fsguard);
+
+    if (fsguard->mi_find_deleted != NULL)
+        gtk_widget_set_visible (fsguard->mi_find_deleted, fsguard->remote == NULL);
+}
+
+static void
+fsguard_unwatch (FsGuard *fsguard)
+{
+    if (fsguard->remote != NULL) {
+        fsguard_remote_unsubscribe (fsguard->remote);
+        fsguard->remote = NULL;
+    }
+    if (fsguard->check != NULL) {
+        fsguard_check_release (fsguard->check);
+        fsguard->check = NULL;
+    }
+
+    fsguard->seen = FALSE;
+    fsguard->sampled = 0;
+    fsguard_forget_deleted (fsguard);
+}
+
+static void
 fsguard_check_fs_cb (gpointer user_data)
+{
+    fsguard_check_fs (user_data);
+}
+
+static void
+fsguard_map_changed (GtkWidget *widget, FsGuard *fsguard)
+{
+    fsguard_schedule_set_mapped (fsguard->schedule, gtk_widget_get_mapped (widget));
+}
+
+static void
+fsguard_session_changed (gboolean idle, gboolean locked, gboolean on_battery, gpointer user_data)
 {
     FsGuard *fsguard = user_data;
 
-    fsguard_check_fs (fsguard);
-    return TRUE;
+    fsguard_schedule_set_session (fsguard->schedule, idle, locked, on_battery);
 }
 
 static void
@@ -348,7 +965,10 @@ fsguard_read_config (FsGuard *fsguard)
     fsguard->seen               = FALSE;
     fsguard->name               = g_strdup ("");
     fsguard->show_name          = FALSE;
+    fsguard->mounted_only       = FALSE;
+    fsguard->attribute_writers  = FALSE;
     fsguard->path               = g_strdup ("/");
+    fsguard->agent              = g_strdup ("");
     fsguard->css_class          = g_strdup ("normal");
     fsguard->show_size          = TRUE;
     fsguard->show_progress_bar  = TRUE;
@@ -369,6 +989,10 @@ fsguard_read_config (FsGuard *fsguard)
     fsguard->show_name          = xfce_rc_read_bool_entry (rc, "label_visible", FALSE);
     g_free (fsguard->path);
     fsguard->path               = g_strdup (xfce_rc_read_entry (rc, "mnt", "/"));
+    g_free (fsguard->agent);
+    fsguard->agent              = g_strdup (xfce_rc_read_entry (rc, "agent", ""));
+    fsguard->mounted_only       = xfce_rc_read_bool_entry (rc, "mounted_only", FALSE);
+    fsguard->attribute_writers  = xfce_rc_read_bool_entry (rc, "attribute_writers", FALSE);
     fsguard->show_size          = xfce_rc_read_bool_entry (rc, "lab_size_visible", TRUE);
     fsguard->show_progress_bar  = xfce_rc_read_bool_entry (rc, "progress_bar_visible", TRUE);
     fsguard->hide_button        = xfce_rc_read_bool_entry (rc, "hide_button", FALSE);
@@ -402,6 +1026,9 @@ fsguard_write_config (XfcePanelPlugin *plugin, FsGuard *fsguard)
     xfce_rc_write_entry (rc, "label", fsguard->name);
     xfce_rc_write_bool_entry (rc, "label_visible", fsguard->show_name);
     xfce_rc_write_entry (rc, "mnt", fsguard->path);
+    xfce_rc_write_entry (rc, "agent", fsguard->agent);
+    xfce_rc_write_bool_entry (rc, "mounted_only", fsguard->mounted_only);
+    xfce_rc_write_bool_entry (rc, "attribute_writers", fsguard->attribute_writers);
 
     xfce_rc_close (rc);
 }    
@@ -410,92 +1037,71 @@ static FsGuard *
 fsguard_new (XfcePanelPlugin *plugin)
 {
     GtkOrientation orientation = xfce_panel_plugin_get_orientation (plugin);
-    GtkCssProvider *css_provider;
     FsGuard *fsguard = g_new0(FsGuard, 1);
 
+    FSGUARD_TRACE_BEGIN (new);
     fsguard->plugin = plugin;
+    fsguard->status = FSGUARD_PROBE_ERROR;
 
     fsguard_read_config (fsguard);
+    fsguard_watch (fsguard);
+    fsguard->schedule = fsguard_schedule_new (CHECK_INTERVAL, CHECK_INTERVAL_BATTERY,
+                                              fsguard_check_fs_cb, fsguard);
 
     fsguard->ebox = gtk_event_box_new();
     gtk_event_box_set_visible_window(GTK_EVENT_BOX(fsguard->ebox), FALSE);
 
     fsguard->box = gtk_box_new (orientation, 2);
-
-    fsguard->lab_name = gtk_label_new (NULL);
-    fsguard->lab_size = gtk_label_new (NULL);
     fsguard->lab_box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 2);
 
     gtk_widget_set_halign(fsguard->lab_box, GTK_ALIGN_CENTER);
     gtk_widget_set_valign(fsguard->lab_box, GTK_ALIGN_CENTER);
 
-    fsguard->btn_panel = xfce_panel_create_button ();
-    fsguard->icon_panel = gtk_image_new ();
-
-    fsguard->progress_bar = gtk_progress_bar_new ();
-    css_provider = gtk_css_provider_new ();
-        gtk_css_provider_load_from_data (css_provider, "\
-            progressbar.horizontal trough { min-height: 4px; }\
-            progressbar.horizontal progress { min-height: 4px; }\
-            progressbar.vertical trough { min-width: 4px; }\
-            progressbar.vertical progress { min-width: 4px; }\
-            .normal progress { background-color: " COLOR_NORMAL " ; background-image: none; }\
-            .warning progress { background-color: " COLOR_WARNING " ; background-image: none; }\
-            .urgent progress { background-color: " COLOR_URGENT " ; background-image: none; }",
-             -1, NULL);
-    gtk_style_context_add_provider (
-        GTK_STYLE_CONTEXT (gtk_widget_get_style_context (GTK_WIDGET (fsguard->progress_bar))),
-        GTK_STYLE_PROVIDER (css_provider),
-        GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
-    g_object_unref (css_provider);
-    gtk_style_context_add_class (
-        GTK_STYLE_CONTEXT(gtk_widget_get_style_context (GTK_WIDGET (fsguard->progress_bar))),
-        fsguard->css_class);
-    gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR(fsguard->progress_bar), 0.0);
-    gtk_progress_bar_set_inverted (GTK_PROGRESS_BAR(fsguard->progress_bar), (orientation == GTK_ORIENTATION_HORIZONTAL));
-    gtk_orientable_set_orientation (GTK_ORIENTABLE(fsguard->progress_bar), !orientation);
-    fsguard->pb_box = gtk_box_new (orientation, 0);
-
-    g_signal_connect (G_OBJECT(fsguard->btn_panel),
-                      "clicked",
-                      G_CALLBACK(fsguard_open_mnt),
-                      fsguard);
-
     gtk_container_add (GTK_CONTAINER(fsguard->ebox), fsguard->box);
-    gtk_container_add (GTK_CONTAINER(fsguard->box), fsguard->btn_panel);
-    gtk_container_add (GTK_CONTAINER(fsguard->btn_panel), fsguard->icon_panel);
-    gtk_container_add (GTK_CONTAINER(fsguard->lab_box), fsguard->lab_name);
-    gtk_container_add (GTK_CONTAINER(fsguard->lab_box), fsguard->lab_size);
     gtk_container_add (GTK_CONTAINER(fsguard->box), fsguard->lab_box);
-    gtk_container_add (GTK_CONTAINER(fsguard->box), fsguard->pb_box);
-    gtk_container_add (GTK_CONTAINER(fsguard->pb_box), fsguard->progress_bar);
+
+    g_signal_connect (G_OBJECT(fsguard->ebox),
+                      "map",
+                      G_CALLBACK(fsguard_map_changed),
+                      fsguard);
+    g_signal_connect (G_OBJECT(fsguard->ebox),
+                      "unmap",
+                      G_CALLBACK(fsguard_map_changed),
+                      fsguard);
 
     xfce_panel_plugin_add_action_widget (plugin, fsguard->ebox);
-    xfce_panel_plugin_add_action_widget (plugin, fsguard->btn_panel);
 
     gtk_widget_set_size_request(fsguard->ebox, -1, -1);
-    gtk_widget_show_all (fsguard->ebox);
+    gtk_widget_show (fsguard->box);
+    gtk_widget_show (fsguard->ebox);
+
+    /* Only the displayed elements are created, see fsguard_refresh_*() */
+    FSGUARD_TRACE_BEGIN (widgets);
+    fsguard_refresh_btn_panel (fsguard);
     fsguard_refresh_name (fsguard);
-    fsguard_refresh_button (fsguard);
-    if (fsguard->show_size != TRUE)
-        gtk_widget_hide (fsguard->lab_size);
-    if (fsguard->show_progress_bar != TRUE)
-        gtk_widget_hide (fsguard->pb_box);
-    if (fsguard->hide_button != FALSE)
-        gtk_widget_hide (fsguard->btn_panel);
+    fsguard_refresh_lab_size (fsguard);
+    fsguard_refresh_progress_bar (fsguard);
+    fsguard_layout_labels (fsguard);
+    FSGUARD_TRACE_END (widgets, fsguard->path);
 
+    FSGUARD_TRACE_END (new, fsguard->path);
     return fsguard;
 }
 
 static void
 fsguard_free (XfcePanelPlugin *plugin, FsGuard *fsguard)
 {
-    if (fsguard->timeout != 0) {
-        g_source_remove (fsguard->timeout);
-    }
+    g_signal_handlers_disconnect_by_data (fsguard->ebox, fsguard);
+    fsguard_schedule_free (fsguard->schedule);
+    fsguard_unwatch (fsguard);
+    fsguard_attribution_release (fsguard);
+
+    if (fsguard->session != NULL)
+        fsguard_session_free (fsguard->session);
 
     g_free (fsguard->name);
     g_free (fsguard->path);
+    g_free (fsguard->agent);
     g_free (fsguard->css_class);
 
     g_free(fsguard);
@@ -504,24 +1110,18 @@ fsguard_free (XfcePanelPlugin *plugin, FsGuard *fsguard)
 static gboolean
 fsguard_set_size (XfcePanelPlugin *plugin, int size, FsGuard *fsguard)
 {
-    int border_width = (size > 26 ? 2 : 1);
     GtkOrientation orientation = xfce_panel_plugin_get_orientation (plugin);
 
     size /= xfce_panel_plugin_get_nrows (plugin);
     DBG ("Set size to `%d'", size);
 
-    gtk_container_set_border_width (GTK_CONTAINER (fsguard->pb_box), border_width);
-
     if (orientation == GTK_ORIENTATION_HORIZONTAL) {
-        gtk_widget_set_size_request (GTK_WIDGET(fsguard->progress_bar), 8, -1);
         gtk_widget_set_size_request (GTK_WIDGET(plugin), -1, size);
     } else {
-        gtk_widget_set_size_request (GTK_WIDGET(fsguard->progress_bar), -1, 8);
         gtk_widget_set_size_request (GTK_WIDGET(plugin), size, -1);
     }
-    gtk_widget_set_size_request (fsguard->btn_panel, size, size);
-    size -= 2 * border_width;
-    gtk_widget_set_size_request (fsguard->icon_panel, size, size);
+    fsguard_layout_progress_bar (fsguard);
+    fsguard_layout_button (fsguard);
 
     fsguard_refresh_icon (fsguard);
 
@@ -531,11 +1131,8 @@ fsguard_set_size (XfcePanelPlugin *plugin, int size, FsGuard *fsguard)
 static void
 fsguard_set_mode (XfcePanelPlugin *plugin, XfcePanelPluginMode mode, FsGuard *fsguard)
 {
-    GtkOrientation orientation, panel_orientation;
+    GtkOrientation panel_orientation;
 
-    orientation =
-      (mode != XFCE_PANEL_PLUGIN_MODE_VERTICAL) ?
-      GTK_ORIENTATION_HORIZONTAL : GTK_ORIENTATION_VERTICAL;
     panel_orientation =
       (mode == XFCE_PANEL_PLUGIN_MODE_HORIZONTAL) ?
       GTK_ORIENTATION_HORIZONTAL : GTK_ORIENTATION_VERTICAL;
@@ -544,18 +1141,7 @@ fsguard_set_mode (XfcePanelPlugin *plugin, XfcePanelPluginMode mode, FsGuard *fs
          "Horizontal" : (mode == XFCE_PANEL_PLUGIN_MODE_VERTICAL ? "Vertical" : "Deskbar"));
 
     gtk_orientable_set_orientation (GTK_ORIENTABLE (fsguard->box), panel_orientation);
-    gtk_orientable_set_orientation (GTK_ORIENTABLE (fsguard->pb_box), panel_orientation);
-    gtk_orientable_set_orientation (GTK_ORIENTABLE (fsguard->progress_bar), !panel_orientation);
-    gtk_progress_bar_set_inverted (GTK_PROGRESS_BAR(fsguard->progress_bar), (panel_orientation == GTK_ORIENTATION_HORIZONTAL));
-    gtk_label_set_angle (GTK_LABEL(fsguard->lab_name),
-                         orientation == GTK_ORIENTATION_VERTICAL ? -90 : 0);
-    gtk_label_set_angle (GTK_LABEL(fsguard->lab_size),
-                         orientation == GTK_ORIENTATION_VERTICAL ? -90 : 0);
-    gtk_orientable_set_orientation (GTK_ORIENTABLE (fsguard->lab_box),
-                                orientation == GTK_ORIENTATION_VERTICAL ?
-                                GTK_ORIENTATION_HORIZONTAL : GTK_ORIENTATION_VERTICAL);
-    gtk_box_reorder_child (GTK_BOX (fsguard->lab_box),
-                           orientation == GTK_ORIENTATION_VERTICAL ? fsguard->lab_size : fsguard->lab_name, 0);
+    fsguard_layout_labels (fsguard);
     fsguard_set_size (plugin, xfce_panel_plugin_get_size (plugin), fsguard);
 }
 
@@ -564,23 +1150,56 @@ fsguard_entry1_changed (GtkWidget *widget, FsGuard *fsguard)
 {
     g_free (fsguard->path);
     fsguard->path = g_strdup (gtk_entry_get_text (GTK_ENTRY(widget)));
-    fsguard->seen = FALSE;
+    fsguard_unwatch (fsguard);
+    fsguard_watch (fsguard);
     fsguard_check_fs (fsguard);
 }
 
+static void
+fsguard_entry2_changed (GtkWidget *widget, FsGuard *fsguard)
+{
+    g_free (fsguard->agent);
+    fsguard->agent = g_strdup (gtk_entry_get_text (GTK_ENTRY(widget)));
+    fsguard_unwatch (fsguard);
+    fsguard_watch (fsguard);
+    fsguard_check_fs (fsguard);
+}
+
+static void
+fsguard_check5_changed (GtkWidget *widget, FsGuard *fsguard)
+{
+    fsguard->mounted_only = gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON(widget));
+    if (fsguard->remote != NULL) {
+        fsguard_unwatch (fsguard);
+        fsguard_watch (fsguard);
+    }
+    fsguard_check_fs (fsguard);
+}
+
+static void
+fsguard_check6_changed (GtkWidget *widget, FsGuard *fsguard)
+{
+    fsguard->attribute_writers = gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON(widget));
+    if (!fsguard->attribute_writers) {
+        fsguard_attribution_release (fsguard);
+        fsguard->n_writers = 0;
+        fsguard_update (fsguard);
+    }
+}
+
 static void
 fsguard_spin1_changed (GtkWidget *widget, FsGuard *fsguard)
 {
     fsguard->limit_warning = gtk_spin_button_get_value_as_int (GTK_SPIN_BUTTON(widget));
     fsguard->seen = FALSE;
-    fsguard_check_fs (fsguard);
+    fsguard_update (fsguard);
 }
 
 static void
 fsguard_spin2_changed (GtkWidget *widget, FsGuard *fsguard)
 {
     fsguard->limit_urgent = gtk_spin_button_get_value_as_int (GTK_SPIN_BUTTON(widget));
-    fsguard_check_fs (fsguard);
+    fsguard_update (fsguard);
 }
 
 static void
@@ -602,24 +1221,22 @@ static void
 fsguard_check2_changed (GtkWidget *widget, FsGuard *fsguard)
 {
     fsguard->show_size = gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON(widget));
+    fsguard_refresh_lab_size (fsguard);
     if (fsguard->show_size)
-        gtk_widget_show (fsguard->lab_size);
-    else {
-        gtk_widget_hide (fsguard->lab_size);
+        fsguard_update (fsguard);
+    else
         fsguard_refresh_button (fsguard);
-    }
 }
 
 static void
 fsguard_check3_changed (GtkWidget *widget, FsGuard *fsguard)
 {
     fsguard->show_progress_bar = gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON(widget));
+    fsguard_refresh_progress_bar (fsguard);
     if (fsguard->show_progress_bar)
-        gtk_widget_show (fsguard->pb_box);
-    else {
-        gtk_widget_hide (fsguard->pb_box);
+        fsguard_update (fsguard);
+    else
         fsguard_refresh_button (fsguard);
-    }
 }
 
 static void
@@ -627,12 +1244,11 @@ fsguard_check4_changed (GtkWidget *widget, FsGuard *fsguard)
 {
     fsguard->hide_button = !gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON(widget));
 
+    fsguard_refresh_btn_panel (fsguard);
     if (!fsguard->hide_button)
-        gtk_widget_show (fsguard->btn_panel);
-    else {
-        gtk_widget_hide (fsguard->btn_panel);
+        fsguard_refresh_icon (fsguard);
+    else
         fsguard_refresh_button (fsguard);
-    }
 }
 
 static void
@@ -651,10 +1267,14 @@ fsguard_create_options (XfcePanelPlugin *plugin, FsGuard *fsguard)
     GtkWidget *alignment;
     GtkWidget *label1;
     GtkWidget *entry1;
+    GtkWidget *label2;
+    GtkWidget *entry2;
     GtkWidget *label3;
     GtkWidget *spin1;
     GtkWidget *label4;
     GtkWidget *spin2;
+    GtkWidget *check5;
+    GtkWidget *check6;
     GtkWidget *table2;
     GtkWidget *frame2;
     GtkWidget *check1;
@@ -703,6 +1323,17 @@ fsguard_create_options (XfcePanelPlugin *plugin, FsGuard *fsguard)
 
     gtk_size_group_add_widget (size_group, label1);
 
+    label2 = gtk_label_new (_("Agent"));
+    gtk_widget_set_valign(label2, GTK_ALIGN_CENTER);
+    gtk_label_set_xalign (GTK_LABEL (label2), 0.0f);
+    entry2 = gtk_entry_new ();
+    gtk_entry_set_text (GTK_ENTRY (entry2), fsguard->agent);
+    gtk_entry_set_placeholder_text (GTK_ENTRY (entry2), _("Local"));
+    gtk_widget_set_tooltip_text (entry2,
+                                 _("Check the mount point on the host running xfce4-fsguard-agent at this address, either host:port or unix:/path/to/socket"));
+
+    gtk_size_group_add_widget (size_group, label2);
+
     label3 = gtk_label_new (_("Warning limit (%)"));
     gtk_widget_set_valign(label3, GTK_ALIGN_CENTER);
     gtk_label_set_xalign (GTK_LABEL (label3), 0.0f);
@@ -721,18 +1352,38 @@ fsguard_create_options (XfcePanelPlugin *plugin, FsGuard *fsguard)
 
     gtk_size_group_add_widget (size_group, label4);
 
+    check5 = gtk_check_button_new_with_label (_("Only check while mounted"));
+    gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (check5),
+                                  fsguard->mounted_only);
+    gtk_widget_set_tooltip_text (check5,
+                                 _("Skip the mount point while nothing is mounted on it"));
+
+    check6 = gtk_check_button_new_with_label (_("Show top writers"));
+    gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (check6),
+                                  fsguard->attribute_writers);
+    gtk_widget_set_tooltip_text (check6,
+                                 _("List the processes writing the most in the tooltip while the mount point fills up"));
+
     gtk_grid_attach (GTK_GRID (table1), label1,
                                0, 0, 1, 1);
     gtk_grid_attach (GTK_GRID (table1), entry1,
                                1, 0, 1, 1);
-    gtk_grid_attach (GTK_GRID (table1), label3,
+    gtk_grid_attach (GTK_GRID (table1), label2,
                                0, 1, 1, 1);
-    gtk_grid_attach (GTK_GRID (table1), spin1,
+    gtk_grid_attach (GTK_GRID (table1), entry2,
                                1, 1, 1, 1);
-    gtk_grid_attach (GTK_GRID (table1), label4,
+    gtk_grid_attach (GTK_GRID (table1), label3,
                                0, 2, 1, 1);
-    gtk_grid_attach (GTK_GRID (table1), spin2,
+    gtk_grid_attach (GTK_GRID (table1), spin1,
                                1, 2, 1, 1);
+    gtk_grid_attach (GTK_GRID (table1), label4,
+                               0, 3, 1, 1);
+    gtk_grid_attach (GTK_GRID (table1), spin2,
+                               1, 3, 1, 1);
+    gtk_grid_attach (GTK_GRID (table1), check5,
+                               0, 4, 2, 1);
+    gtk_grid_attach (GTK_GRID (table1), check6,
+                               0, 5, 2, 1);
 
     /* Display frame */
     table2 = gtk_grid_new ();
@@ -781,6 +1432,18 @@ fsguard_create_options (XfcePanelPlugin *plugin, FsGuard *fsguard)
                       "changed",
                       G_CALLBACK (fsguard_entry1_changed),
                       fsguard);
+    g_signal_connect (entry2,
+                      "changed",
+                      G_CALLBACK (fsguard_entry2_changed),
+                      fsguard);
+    g_signal_connect (check5,
+                      "toggled",
+                      G_CALLBACK (fsguard_check5_changed),
+                      fsguard);
+    g_signal_connect (check6,
+                      "toggled",
+                      G_CALLBACK (fsguard_check6_changed),
+                      fsguard);
     g_signal_connect (spin1,
                       "value-changed",
                       G_CALLBACK (fsguard_spin1_changed),
@@ -843,13 +1506,12 @@ static void
 fsguard_construct (XfcePanelPlugin *plugin)
 {
     FsGuard *fsguard;
+    GtkWidget *item;
 
     xfce_textdomain(GETTEXT_PACKAGE, PACKAGE_LOCALE_DIR, "UTF-8");
 
     fsguard = fsguard_new (plugin);
- 
-    fsguard_check_fs (fsguard);
-    fsguard->timeout = g_timeout_add (8192, fsguard_check_fs_cb, fsguard);
+    fsguard->session = fsguard_session_new (fsguard_session_changed, fsguard);
 
     gtk_container_add (GTK_CONTAINER (plugin), fsguard->ebox);
     fsguard_set_size(fsguard->plugin, xfce_panel_plugin_get_size(fsguard->plugin), fsguard);
@@ -880,6 +1542,15 @@ fsguard_construct (XfcePanelPlugin *plugin)
                       G_CALLBACK (fsguard_show_about),
                       fsguard);
 
+    item = gtk_menu_item_new_with_mnemonic (_("Find _Deleted Open Files"));
+    g_signal_connect (item,
+                      "activate",
+                      G_CALLBACK (fsguard_find_deleted_cb),
+                      fsguard);
+    gtk_widget_set_visible (item, fsguard->remote == NULL);
+    xfce_panel_plugin_menu_insert_item (plugin, GTK_MENU_ITEM (item));
+    fsguard->mi_find_deleted = item;
+
     xfce_panel_plugin_menu_show_configure (plugin);
     xfce_panel_plugin_menu_show_about (plugin);
 }
@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * A filesystem with nothing in it but a scripted statfs(), to reproduce
+ * slow, stale and failing mounts.  Mounts itself on the directory given as
+ * argument, prints "ready" and then reads commands from stdin, one per line,
+ * each answered with a line:
+ *
+ *   size TOTAL AVAIL   sizes reported from now on, in bytes
+ *   delay MS           statfs() takes that long before answering
+ *   error ERRNO        statfs() fails with that error, 0 to stop failing
+ *   hang               statfs() blocks until released
+ *   release            unblock statfs()
+ *   count              answers "STARTED FINISHED" statfs() calls
+ *
+ * Everything is released and unmounted on end of input.  Exits with 77
+ * when mounting is not possible, as is usual in containers.
+ */
+
+#define FUSE_USE_VERSION 31
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+
+#include <fuse.h>
+#include <glib.h>
+
+#define BLOCK_SIZE              4096
+#define EXIT_SKIP               77
+
+static GMutex       state_lock;
+static GCond        state_cond;
+static guint64      state_total = 1024 * 1024 * 1024;
+static guint64      state_avail = 512 * 1024 * 1024;
+static guint        state_delay = 0;
+static gint         state_error = 0;
+static gboolean     state_hang = FALSE;
+static guint        state_started = 0;
+static guint        state_finished = 0;
+static pthread_t    main_thread;
+
+static int
+test_fs_getattr (const char *path, struct stat *st, struct fuse_file_info *fi)
+{
+    if (strcmp (path, "/") != 0)
+        return -ENOENT;
+
+    memset (st, 0, sizeof (*st));
+    st->st_mode = S_IFDIR | 0755;
+    st->st_nlink = 2;
+
+    return 0;
+}
+
+static int
+test_fs_statfs (const char *path, struct statvfs *st)
+{
+    guint64             total, avail;
+    guint               delay;
+    gint                error;
+
+    g_mutex_lock (&state_lock);
+    state_started++;
+    while (state_hang)
+        g_cond_wait (&state_cond, &state_lock);
+    total = state_total;
+    avail = state_avail;
+    delay = state_delay;
+    error = state_error;
+    g_mutex_unlock (&state_lock);
+
+    if (delay > 0)
+        g_usleep (delay * G_TIME_SPAN_MILLISECOND);
+
+    if (error == 0) {
+        memset (st, 0, sizeof (*st));
+        st->f_bsize = BLOCK_SIZE;
+        st->f_frsize = BLOCK_SIZE;
+        st->f_blocks = total / BLOCK_SIZE;
+        st->f_bfree = avail / BLOCK_SIZE;
+        st->f_bavail = avail / BLOCK_SIZE;
+        st->f_namemax = 255;
+    }
+
+    g_mutex_lock (&state_lock);
+    state_finished++;
+    g_mutex_unlock (&state_lock);
+
+    return -error;
+}
+
+static const struct fuse_operations test_fs_operations =
+{
+    .getattr = test_fs_getattr,
+    .statfs = test_fs_statfs,
+};
+
+static gpointer
+test_fs_commands (gpointer data)
+{
+    gchar               line[256];
+    guint64             total, avail;
+    guint               value;
+
+    while (fgets (line, sizeof (line), stdin) != NULL) {
+        g_mutex_lock (&state_lock);
+        if (sscanf (line, "size %" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT, &total, &avail) == 2) {
+            state_total = total;
+            state_avail = avail;
+            printf ("ok\n");
+        } else if (sscanf (line, "delay %u", &value) == 1) {
+            state_delay = value;
+            printf ("ok\n");
+        } else if (sscanf (line, "error %u", &value) == 1) {
+            state_error = value;
+            printf ("ok\n");
+        } else if (g_str_has_prefix (line, "hang")) {
+            state_hang = TRUE;
+            printf ("ok\n");
+        } else if (g_str_has_prefix (line, "release")) {
+            state_hang = FALSE;
+            g_cond_broadcast (&state_cond);
+            printf ("ok\n");
+        } else if (g_str_has_prefix (line, "count")) {
+            printf ("%u %u\n", state_started, state_finished);
+        } else {
+            printf ("error\n");
+        }
+        g_mutex_unlock (&state_lock);
+        fflush (stdout);
+    }
+
+    g_mutex_lock (&state_lock);
+    state_hang = FALSE;
+    g_cond_broadcast (&state_cond);
+    g_mutex_unlock (&state_lock);
+
+    /* Same as ^C: the FUSE signal handler ends fuse_loop_mt() */
+    pthread_kill (main_thread, SIGTERM);
+
+    return NULL;
+}
+
+int
+main (int argc, char **argv)
+{
+    const gchar        *fuse_argv[] = { argv[0], "-o", "fsname=fsguard-test", NULL };
+    struct fuse_args    args = FUSE_ARGS_INIT (3, (gchar **) fuse_argv);
+    struct fuse        *fuse;
+    GThread            *thread;
+    gint                ret;
+
+    if (argc != 2) {
+        fprintf (stderr, "Usage: %s MOUNTPOINT\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    fuse = fuse_new (&args, &test_fs_operations, sizeof (test_fs_operations), NULL);
+    if (fuse == NULL)
+        return EXIT_SKIP;
+    if (fuse_mount (fuse, argv[1]) != 0) {
+        fuse_destroy (fuse);
+        return EXIT_SKIP;
+    }
+
+    fuse_set_signal_handlers (fuse_get_session (fuse));
+    main_thread = pthread_self ();
+
+    printf ("ready\n");
+    fflush (stdout);
+
+    thread = g_thread_new ("commands", test_fs_commands, NULL);
+    ret = fuse_loop_mt (fuse, 0);
+    g_thread_join (thread);
+    fuse_remove_signal_handlers (fuse_get_session (fuse));
+    fuse_unmount (fuse);
+    fuse_destroy (fuse);
+
+    return (ret == 0 || ret == -SIGTERM) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
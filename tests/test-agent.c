@@ -0,0 +1,344 @@
+/*
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Runs xfce4-fsguard-agent on a unix socket in a temporary directory, the
+ * same way it would run on a remote host, and talks to it with the wire
+ * code of the plugin.
+ */
+
+#undef G_DISABLE_ASSERT
+
+#include <string.h>
+
+#include <glib/gstdio.h>
+
+#include "panel-plugin/fsguard-probe.h"
+#include "panel-plugin/fsguard-wire.h"
+#include "test-util.h"
+
+typedef struct
+{
+    guint               id;
+    guint               flags;
+    gint                status;
+    gint64              total_delta;
+    gint64              avail_delta;
+} Sample;
+
+typedef struct
+{
+    GSubprocess        *agent;
+    gchar              *dir;
+    gchar              *socket;
+    FsGuardChannel     *channel;
+    GQueue              samples;
+    gboolean            closed;
+} Fixture;
+
+static gboolean
+fixture_frame (FsGuardChannel *channel, const guint8 *payload, gsize len, gpointer user_data)
+{
+    Fixture            *fixture = user_data;
+    const guint8       *p = payload + 1;
+    const guint8       *end = payload + len;
+    guint64             id, flags, status;
+    Sample             *sample;
+
+    g_assert_cmpint (payload[0], ==, FSGUARD_WIRE_SAMPLE);
+
+    sample = g_new0 (Sample, 1);
+    g_assert_true (fsguard_wire_get_varint (&p, end, &id));
+    g_assert_true (fsguard_wire_get_varint (&p, end, &flags));
+    g_assert_true (fsguard_wire_get_varint (&p, end, &status));
+    g_assert_true (fsguard_wire_get_svarint (&p, end, &sample->total_delta));
+    g_assert_true (fsguard_wire_get_svarint (&p, end, &sample->avail_delta));
+    g_assert_true (p == end);
+    sample->id = id;
+    sample->flags = flags;
+    sample->status = status;
+    g_queue_push_tail (&fixture->samples, sample);
+
+    return TRUE;
+}
+
+static void
+fixture_closed (FsGuardChannel *channel, gpointer user_data)
+{
+    Fixture *fixture = user_data;
+
+    fixture->closed = TRUE;
+}
+
+typedef struct
+{
+    Fixture            *fixture;
+    guint               id;
+    Sample             *sample;
+} SampleWait;
+
+static gboolean
+fixture_has_sample (gpointer user_data)
+{
+    SampleWait         *wait = user_data;
+    Sample             *sample;
+    GList              *l;
+
+    for (l = wait->fixture->samples.head; l != NULL; l = l->next) {
+        sample = l->data;
+        if (sample->id == wait->id) {
+            g_queue_delete_link (&wait->fixture->samples, l);
+            wait->sample = sample;
+            return TRUE;
+        }
+    }
+
+    return wait->fixture->closed;
+}
+
+/* Returns the next sample for id, NULL when none came within timeout_ms */
+static Sample *
+fixture_wait_sample (Fixture *fixture, guint id, guint timeout_ms)
+{
+    SampleWait          wait = { fixture, id, NULL };
+
+    test_util_wait (fixture_has_sample, &wait, timeout_ms);
+
+    return wait.sample;
+}
+
+static void
+fixture_send (Fixture *fixture, GByteArray *frames)
+{
+    fsguard_channel_send (fixture->channel, frames);
+    g_byte_array_set_size (frames, 0);
+}
+
+static void
+fixture_set_up (Fixture *fixture, gconstpointer data)
+{
+    GSocketConnection  *connection;
+    GError             *error = NULL;
+
+    fixture->dir = g_dir_make_tmp ("fsguard-test-XXXXXX", &error);
+    g_assert_no_error (error);
+    fixture->socket = g_build_filename (fixture->dir, "agent.socket", NULL);
+    fixture->agent = test_util_agent_spawn (fixture->socket);
+
+    connection = test_util_agent_connect (fixture->socket);
+    g_queue_init (&fixture->samples);
+    fixture->channel = fsguard_channel_new (connection, fixture_frame, fixture_closed, fixture);
+    g_object_unref (connection);
+}
+
+static void
+fixture_tear_down (Fixture *fixture, gconstpointer data)
+{
+    fsguard_channel_free (fixture->channel);
+    g_queue_clear_full (&fixture->samples, g_free);
+    test_util_agent_quit (fixture->agent, fixture->socket);
+
+    g_rmdir (fixture->dir);
+    g_free (fixture->socket);
+    g_free (fixture->dir);
+}
+
+static void
+test_wire_encoding (void)
+{
+    static const guint8 expected[] = { 0x86, 0x00, FSGUARD_WIRE_SAMPLE, 1, 0, 0, 0x01, 0x02 };
+    const gint64        deltas[] = { 0, 1, -1, 63, -64, G_MAXINT64, G_MININT64 };
+    const guint8       *p, *end;
+    GByteArray         *frames = g_byte_array_new ();
+    guint64             len, value;
+    gint64              total, avail;
+    guint               i;
+
+    /* Two byte length, then -1 and 1 zigzag encoded as 1 and 2 */
+    fsguard_wire_put_sample (frames, 1, 0, FSGUARD_PROBE_OK, -1, 1);
+    g_assert_cmpmem (frames->data, frames->len, expected, sizeof (expected));
+
+    for (i = 0; i < G_N_ELEMENTS (deltas); i++) {
+        g_byte_array_set_size (frames, 0);
+        fsguard_wire_put_sample (frames, 7, FSGUARD_WIRE_MOUNT_CHANGED, FSGUARD_PROBE_HUNG,
+                                 deltas[i], -deltas[i] - 1);
+
+        p = frames->data;
+        end = p + frames->len;
+        g_assert_true (fsguard_wire_get_varint (&p, end, &len));
+        g_assert_cmpuint (len, ==, end - p);
+        g_assert_cmpint (*p++, ==, FSGUARD_WIRE_SAMPLE);
+        g_assert_true (fsguard_wire_get_varint (&p, end, &value));
+        g_assert_cmpuint (value, ==, 7);
+        g_assert_true (fsguard_wire_get_varint (&p, end, &value));
+        g_assert_cmpuint (value, ==, FSGUARD_WIRE_MOUNT_CHANGED);
+        g_assert_true (fsguard_wire_get_varint (&p, end, &value));
+        g_assert_cmpuint (value, ==, FSGUARD_PROBE_HUNG);
+        g_assert_true (fsguard_wire_get_svarint (&p, end, &total));
+        g_assert_true (fsguard_wire_get_svarint (&p, end, &avail));
+        g_assert_cmpint (total, ==, deltas[i]);
+        g_assert_cmpint (avail, ==, -deltas[i] - 1);
+        g_assert_true (p == end);
+    }
+
+    /* Truncated varints are not read past the end */
+    p = expected;
+    g_assert_false (fsguard_wire_get_varint (&p, expected + 1, &value));
+    g_assert_true (p == expected);
+
+    g_byte_array_unref (frames);
+}
+
+static void
+test_agent_stream (Fixture *fixture, gconstpointer data)
+{
+    FsGuardProbe       *probe;
+    GByteArray         *frames = g_byte_array_new ();
+    Sample             *sample;
+    gchar              *missing;
+    guint64             total = 0;
+    guint64             avail = 0;
+
+    probe = fsguard_probe_new (fixture->dir, FALSE);
+    g_assert_cmpint (fsguard_probe_run (probe), ==, FSGUARD_PROBE_OK);
+
+    /* The first sample carries the whole sizes as deltas from zero */
+    fsguard_wire_put_subscribe (frames, 1, 0, fixture->dir);
+    fixture_send (fixture, frames);
+    sample = fixture_wait_sample (fixture, 1, TEST_TIMEOUT_MS);
+    g_assert_nonnull (sample);
+    g_assert_cmpint (sample->status, ==, FSGUARD_PROBE_OK);
+    g_assert_cmpint (sample->total_delta, ==, (gint64) probe->total);
+    g_assert_cmpint (sample->avail_delta, >, 0);
+    total = sample->total_delta;
+    avail = sample->avail_delta;
+    g_free (sample);
+
+    /* A path which is not there gives the same sample over and over, which
+     * is only sent once */
+    missing = g_build_filename (fixture->dir, "missing", NULL);
+    fsguard_wire_put_subscribe (frames, 2, FSGUARD_WIRE_MOUNTED_ONLY, missing);
+    fixture_send (fixture, frames);
+    sample = fixture_wait_sample (fixture, 2, TEST_TIMEOUT_MS);
+    g_assert_nonnull (sample);
+    g_assert_cmpint (sample->status, ==, FSGUARD_PROBE_ERROR);
+    g_assert_cmpint (sample->total_delta, ==, 0);
+    g_assert_cmpint (sample->avail_delta, ==, 0);
+    g_free (sample);
+    g_assert_null (fixture_wait_sample (fixture, 2, TEST_QUIET_MS));
+
+    /* Subscribing again with the same id is only accepted after the first
+     * subscription went away, the agent hangs up otherwise */
+    fsguard_wire_put_unsubscribe (frames, 2);
+    fsguard_wire_put_subscribe (frames, 2, 0, missing);
+    fixture_send (fixture, frames);
+    sample = fixture_wait_sample (fixture, 2, TEST_TIMEOUT_MS);
+    g_assert_nonnull (sample);
+    g_assert_cmpint (sample->status, ==, FSGUARD_PROBE_ERROR);
+    g_free (sample);
+    g_assert_false (fixture->closed);
+
+    /* Once unsubscribed nothing more comes for it */
+    fsguard_wire_put_unsubscribe (frames, 2);
+    fixture_send (fixture, frames);
+    g_assert_null (fixture_wait_sample (fixture, 2, TEST_QUIET_MS));
+
+    /* Whatever changed meanwhile on the filesystem, the deltas add up */
+    while ((sample = fixture_wait_sample (fixture, 1, 0)) != NULL) {
+        total += sample->total_delta;
+        avail += sample->avail_delta;
+        g_free (sample);
+    }
+    g_assert_cmpuint (total, ==, probe->total);
+    g_assert_cmpuint (avail, >, 0);
+    g_assert_false (fixture->closed);
+
+    g_free (missing);
+    g_byte_array_unref (frames);
+    fsguard_probe_free (probe);
+}
+
+static void
+test_agent_malformed (Fixture *fixture, gconstpointer data)
+{
+    GByteArray         *frames = g_byte_array_new ();
+    static const guint8 oversized[] = { 0xff, 0xff, 0x03 };
+
+    /* A frame over the limit is not waited for, the agent hangs up */
+    g_byte_array_append (frames, oversized, sizeof (oversized));
+    fixture_send (fixture, frames);
+    g_assert_null (fixture_wait_sample (fixture, 1, TEST_TIMEOUT_MS));
+    g_assert_true (fixture->closed);
+
+    g_byte_array_unref (frames);
+}
+
+static void
+test_agent_running (Fixture *fixture, gconstpointer data)
+{
+    GSubprocess        *agent;
+    GByteArray         *frames = g_byte_array_new ();
+    GError             *error = NULL;
+    Sample             *sample;
+    gchar              *listen;
+
+    /* A second agent on the same socket gives up and leaves it alone */
+    listen = g_strconcat ("unix:", fixture->socket, NULL);
+    agent = g_subprocess_new (G_SUBPROCESS_FLAGS_STDERR_SILENCE, &error,
+                              g_getenv ("FSGUARD_AGENT"), "--listen", listen, NULL);
+    g_assert_no_error (error);
+    g_subprocess_wait (agent, NULL, &error);
+    g_assert_no_error (error);
+    g_assert_true (g_subprocess_get_if_exited (agent));
+    g_assert_cmpint (g_subprocess_get_exit_status (agent), !=, 0);
+    g_object_unref (agent);
+    g_free (listen);
+
+    g_assert_true (g_file_test (fixture->socket, G_FILE_TEST_EXISTS));
+    fsguard_wire_put_subscribe (frames, 1, 0, fixture->dir);
+    fixture_send (fixture, frames);
+    sample = fixture_wait_sample (fixture, 1, TEST_TIMEOUT_MS);
+    g_assert_nonnull (sample);
+    g_assert_cmpint (sample->status, ==, FSGUARD_PROBE_OK);
+    g_free (sample);
+
+    g_byte_array_unref (frames);
+}
+
+int
+main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/wire/encoding", test_wire_encoding);
+    g_test_add ("/agent/stream", Fixture, NULL,
+                fixture_set_up, test_agent_stream, fixture_tear_down);
+    g_test_add ("/agent/malformed", Fixture, NULL,
+                fixture_set_up, test_agent_malformed, fixture_tear_down);
+    g_test_add ("/agent/running", Fixture, NULL,
+                fixture_set_up, test_agent_running, fixture_tear_down);
+
+    return g_test_run ();
+}
@@ -0,0 +1,417 @@
+/*
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Runs the checks of the plugin against fsguard-test-fs, a FUSE filesystem
+ * whose statfs() can be made slow, failing or blocked, while a heartbeat in
+ * the main loop makes sure it keeps running meanwhile.  The
+ * check path does not touch GTK, so no display is needed.
+ */
+
+#undef G_DISABLE_ASSERT
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+
+#include "panel-plugin/fsguard-check.h"
+#include "panel-plugin/fsguard-probe.h"
+#include "test-util.h"
+
+#define PROBE_TIMEOUT_MS        1000
+/* How often the plugin would run the check of a busy probe */
+#define POLL_MS                 100
+#define HEARTBEAT_MS            10
+/* Far less than the heartbeats of a blocked probe, even on a loaded
+ * machine, but more than a main loop blocked in statfs() would see */
+#define MIN_HEARTBEATS          5
+
+#define GiB                     ((guint64) 1024 * 1024 * 1024)
+
+typedef struct
+{
+    gint                status;
+    guint64             total;
+    guint64             avail;
+} Result;
+
+typedef struct
+{
+    GSubprocess        *fs;
+    GDataInputStream   *fs_out;
+    gchar              *dir;
+
+    FsGuardCheck       *check;
+    GQueue              results;
+    guint               poll_id;
+
+    guint               heartbeat_id;
+    guint               heartbeats;
+} Fixture;
+
+static GSubprocess *
+fs_spawn (const gchar *dir, GDataInputStream **fs_out)
+{
+    GSubprocess        *fs;
+    GError             *error = NULL;
+    gchar              *line;
+
+    fs = g_subprocess_new (G_SUBPROCESS_FLAGS_STDIN_PIPE | G_SUBPROCESS_FLAGS_STDOUT_PIPE, &error,
+                           g_getenv ("FSGUARD_TEST_FS"), dir, NULL);
+    g_assert_no_error (error);
+    *fs_out = g_data_input_stream_new (g_subprocess_get_stdout_pipe (fs));
+
+    /* Nothing but the exit status when it cannot mount */
+    line = g_data_input_stream_read_line (*fs_out, NULL, NULL, NULL);
+    if (g_strcmp0 (line, "ready") != 0) {
+        g_subprocess_wait (fs, NULL, NULL);
+        g_clear_object (fs_out);
+        g_clear_object (&fs);
+    }
+    g_free (line);
+
+    return fs;
+}
+
+static void
+fs_quit (GSubprocess *fs, GDataInputStream *fs_out)
+{
+    GError *error = NULL;
+
+    /* End of input releases everything and unmounts */
+    g_output_stream_close (g_subprocess_get_stdin_pipe (fs), NULL, NULL);
+    g_subprocess_wait (fs, NULL, &error);
+    g_assert_no_error (error);
+    g_assert_true (g_subprocess_get_successful (fs));
+    g_object_unref (fs_out);
+    g_object_unref (fs);
+}
+
+static gchar *
+fixture_command (Fixture *fixture, const gchar *command)
+{
+    GOutputStream      *in = g_subprocess_get_stdin_pipe (fixture->fs);
+    GError             *error = NULL;
+    gchar              *line;
+
+    g_output_stream_printf (in, NULL, NULL, &error, "%s\n", command);
+    g_assert_no_error (error);
+    line = g_data_input_stream_read_line (fixture->fs_out, NULL, NULL, &error);
+    g_assert_no_error (error);
+    g_assert_nonnull (line);
+
+    return line;
+}
+
+static void
+fixture_set (Fixture *fixture, const gchar *command)
+{
+    gchar *line = fixture_command (fixture, command);
+
+    g_assert_cmpstr (line, ==, "ok");
+    g_free (line);
+}
+
+typedef struct
+{
+    Fixture            *fixture;
+    guint               started;
+    guint               finished;
+} StatfsWait;
+
+static gboolean
+fixture_has_statfs (gpointer user_data)
+{
+    StatfsWait         *wait = user_data;
+    gchar              *line;
+    guint               started, finished;
+
+    line = fixture_command (wait->fixture, "count");
+    g_assert_cmpint (sscanf (line, "%u %u", &started, &finished), ==, 2);
+    g_free (line);
+
+    return started == wait->started && finished == wait->finished;
+}
+
+/* Waits for the number of statfs() calls of the filesystem to be reached */
+static void
+fixture_wait_statfs (Fixture *fixture, guint started, guint finished)
+{
+    StatfsWait          wait = { fixture, started, finished };
+
+    g_assert_true (test_util_wait (fixture_has_statfs, &wait, TEST_TIMEOUT_MS));
+}
+
+static void
+fixture_result (gint status, guint64 total, guint64 avail, gboolean mnt_changed, gpointer user_data)
+{
+    Fixture            *fixture = user_data;
+    Result             *result = g_new0 (Result, 1);
+
+    result->status = status;
+    result->total = total;
+    result->avail = avail;
+    g_queue_push_tail (&fixture->results, result);
+}
+
+static gboolean
+fixture_heartbeat (gpointer user_data)
+{
+    Fixture *fixture = user_data;
+
+    fixture->heartbeats++;
+
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+fixture_poll (gpointer user_data)
+{
+    Fixture *fixture = user_data;
+
+    fsguard_check_run (fixture->check, FALSE);
+
+    return G_SOURCE_CONTINUE;
+}
+
+/* Returns the next result of the check, NULL when none came within timeout_ms */
+static Result *
+fixture_wait_result (Fixture *fixture, guint timeout_ms)
+{
+    return test_util_wait_pop (&fixture->results, timeout_ms);
+}
+
+static void
+fixture_run (Fixture *fixture)
+{
+    fsguard_check_run (fixture->check, FALSE);
+}
+
+static void
+fixture_set_up (Fixture *fixture, gconstpointer data)
+{
+    GError *error = NULL;
+
+    fixture->dir = g_dir_make_tmp ("fsguard-test-XXXXXX", &error);
+    g_assert_no_error (error);
+    fixture->fs = fs_spawn (fixture->dir, &fixture->fs_out);
+    g_assert_nonnull (fixture->fs);
+
+    g_queue_init (&fixture->results);
+    fixture->check = fsguard_check_new (fixture->dir, PROBE_TIMEOUT_MS * G_TIME_SPAN_MILLISECOND,
+                                        fixture_result, fixture);
+
+    fixture->heartbeat_id = g_timeout_add (HEARTBEAT_MS, fixture_heartbeat, fixture);
+}
+
+static void
+fixture_tear_down (Fixture *fixture, gconstpointer data)
+{
+    g_source_remove (fixture->heartbeat_id);
+
+    if (fixture->poll_id != 0)
+        g_source_remove (fixture->poll_id);
+    if (fixture->check != NULL)
+        fsguard_check_release (fixture->check);
+    fs_quit (fixture->fs, fixture->fs_out);
+    g_queue_clear_full (&fixture->results, g_free);
+
+    g_rmdir (fixture->dir);
+    g_free (fixture->dir);
+}
+
+static void
+test_check_size (Fixture *fixture, gconstpointer data)
+{
+    gchar              *command;
+    Result             *result;
+
+    command = g_strdup_printf ("size %" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT, 8 * GiB, 2 * GiB);
+    fixture_set (fixture, command);
+    g_free (command);
+    fixture_run (fixture);
+    result = fixture_wait_result (fixture, TEST_TIMEOUT_MS);
+    g_assert_nonnull (result);
+    g_assert_cmpint (result->status, ==, FSGUARD_PROBE_OK);
+    g_assert_cmpuint (result->total, ==, 8 * GiB);
+    g_assert_cmpuint (result->avail, ==, 2 * GiB);
+    g_free (result);
+
+    /* Each run probes again */
+    command = g_strdup_printf ("size %" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT, 8 * GiB, GiB);
+    fixture_set (fixture, command);
+    g_free (command);
+    fixture_run (fixture);
+    result = fixture_wait_result (fixture, TEST_TIMEOUT_MS);
+    g_assert_nonnull (result);
+    g_assert_cmpint (result->status, ==, FSGUARD_PROBE_OK);
+    g_assert_cmpuint (result->avail, ==, GiB);
+    g_free (result);
+}
+
+static void
+test_check_error (Fixture *fixture, gconstpointer data)
+{
+    gchar              *command;
+    Result             *result;
+
+    command = g_strdup_printf ("error %d", EIO);
+    fixture_set (fixture, command);
+    g_free (command);
+    fixture_run (fixture);
+    result = fixture_wait_result (fixture, TEST_TIMEOUT_MS);
+    g_assert_nonnull (result);
+    g_assert_cmpint (result->status, ==, FSGUARD_PROBE_ERROR);
+    g_free (result);
+
+    fixture_set (fixture, "error 0");
+    fixture_run (fixture);
+    result = fixture_wait_result (fixture, TEST_TIMEOUT_MS);
+    g_assert_nonnull (result);
+    g_assert_cmpint (result->status, ==, FSGUARD_PROBE_OK);
+    g_free (result);
+}
+
+static void
+test_check_slow (Fixture *fixture, gconstpointer data)
+{
+    gchar              *command;
+    Result             *result;
+    guint               heartbeats;
+
+    /* Slow but within the timeout is just late, and not in the main loop */
+    command = g_strdup_printf ("delay %d", PROBE_TIMEOUT_MS / 2);
+    fixture_set (fixture, command);
+    g_free (command);
+    heartbeats = fixture->heartbeats;
+    fixture_run (fixture);
+    result = fixture_wait_result (fixture, TEST_TIMEOUT_MS);
+    g_assert_nonnull (result);
+    g_assert_cmpint (result->status, ==, FSGUARD_PROBE_OK);
+    g_assert_cmpuint (fixture->heartbeats - heartbeats, >=, MIN_HEARTBEATS);
+    g_free (result);
+}
+
+static void
+test_check_hung (Fixture *fixture, gconstpointer data)
+{
+    Result             *result;
+    gint64              started;
+    guint               heartbeats;
+
+    fixture_set (fixture, "hang");
+    started = g_get_monotonic_time ();
+    heartbeats = fixture->heartbeats;
+    fixture_run (fixture);
+    fixture->poll_id = g_timeout_add (POLL_MS, fixture_poll, fixture);
+
+    /* Not responding once the timeout is over, told once */
+    result = fixture_wait_result (fixture, TEST_TIMEOUT_MS);
+    g_assert_nonnull (result);
+    g_assert_cmpint (result->status, ==, FSGUARD_PROBE_HUNG);
+    g_assert_cmpint (g_get_monotonic_time () - started, >=, PROBE_TIMEOUT_MS * G_TIME_SPAN_MILLISECOND);
+    g_assert_cmpuint (fixture->heartbeats - heartbeats, >=, MIN_HEARTBEATS);
+    g_free (result);
+    heartbeats = fixture->heartbeats;
+    g_assert_null (fixture_wait_result (fixture, TEST_QUIET_MS));
+    g_assert_cmpuint (fixture->heartbeats - heartbeats, >=, MIN_HEARTBEATS);
+
+    /* The runs meanwhile did not pile up behind the blocked one */
+    fixture_wait_statfs (fixture, 1, 0);
+    g_source_remove (fixture->poll_id);
+    fixture->poll_id = 0;
+
+    /* And it is back as soon as the filesystem answers */
+    fixture_set (fixture, "release");
+    result = fixture_wait_result (fixture, TEST_TIMEOUT_MS);
+    g_assert_nonnull (result);
+    g_assert_cmpint (result->status, ==, FSGUARD_PROBE_OK);
+    g_free (result);
+    fixture_wait_statfs (fixture, 1, 1);
+}
+
+static void
+test_check_abandoned (Fixture *fixture, gconstpointer data)
+{
+    fixture_set (fixture, "hang");
+    fixture_run (fixture);
+    fixture_wait_statfs (fixture, 1, 0);
+
+    /* Released while blocked, as on a change of mount point or the removal
+     * of the plugin: the probe ending later must not call back */
+    fsguard_check_release (fixture->check);
+    fixture->check = NULL;
+    fixture_set (fixture, "release");
+    fixture_wait_statfs (fixture, 1, 1);
+    g_assert_null (fixture_wait_result (fixture, TEST_QUIET_MS));
+}
+
+/* FUSE mounts are not allowed everywhere, containers in particular */
+static gboolean
+fs_available (void)
+{
+    GDataInputStream   *fs_out;
+    GSubprocess        *fs;
+    gboolean            available;
+    gchar              *dir;
+
+    dir = g_dir_make_tmp ("fsguard-test-XXXXXX", NULL);
+    g_assert_nonnull (dir);
+    fs = fs_spawn (dir, &fs_out);
+    available = (fs != NULL);
+    if (available)
+        fs_quit (fs, fs_out);
+    g_rmdir (dir);
+    g_free (dir);
+
+    return available;
+}
+
+int
+main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    if (!fs_available ()) {
+        g_printerr ("Cannot mount fsguard-test-fs, skipping\n");
+        return TEST_EXIT_SKIP;
+    }
+
+    g_test_add ("/check/size", Fixture, NULL,
+                fixture_set_up, test_check_size, fixture_tear_down);
+    g_test_add ("/check/error", Fixture, NULL,
+                fixture_set_up, test_check_error, fixture_tear_down);
+    g_test_add ("/check/slow", Fixture, NULL,
+                fixture_set_up, test_check_slow, fixture_tear_down);
+    g_test_add ("/check/hung", Fixture, NULL,
+                fixture_set_up, test_check_hung, fixture_tear_down);
+    g_test_add ("/check/abandoned", Fixture, NULL,
+                fixture_set_up, test_check_abandoned, fixture_tear_down);
+
+    return g_test_run ();
+}
@@ -0,0 +1,393 @@
+/*
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Runs the plugin side of the agent protocol, fsguard-remote.c, against
+ * xfce4-fsguard-agent and against a fake agent in the test itself, which
+ * sees exactly what the plugin sends and answers with chosen samples.
+ */
+
+#undef G_DISABLE_ASSERT
+
+#include <string.h>
+
+#include <glib/gstdio.h>
+#include <gio/gunixsocketaddress.h>
+
+#include "panel-plugin/fsguard-probe.h"
+#include "panel-plugin/fsguard-remote.h"
+#include "panel-plugin/fsguard-wire.h"
+#include "test-util.h"
+
+/* RECONNECT_DELAY of fsguard-remote.c, waited for after the agent is lost */
+#define RECONNECT_MS            10000
+
+typedef struct
+{
+    gint                status;
+    guint64             total;
+    guint64             avail;
+    gboolean            mnt_changed;
+} Result;
+
+typedef struct
+{
+    FsGuardRemote      *remote;
+    GQueue              results;
+} Watch;
+
+/* A frame received by the fake agent */
+typedef struct
+{
+    guint               type;
+    guint               id;
+    guint               flags;
+    gchar              *path;
+} Frame;
+
+typedef struct
+{
+    gchar              *dir;
+    gchar              *socket;
+    gchar              *address;
+    GSubprocess        *agent;
+
+    /* fake agent */
+    GSocketService     *service;
+    guint               connections;
+    FsGuardChannel     *peer;
+    GQueue              frames;
+} Fixture;
+
+static void
+watch_result (gint status, guint64 total, guint64 avail, gboolean mnt_changed, gpointer user_data)
+{
+    Watch              *watch = user_data;
+    Result             *result = g_new0 (Result, 1);
+
+    result->status = status;
+    result->total = total;
+    result->avail = avail;
+    result->mnt_changed = mnt_changed;
+    g_queue_push_tail (&watch->results, result);
+}
+
+static void
+watch_subscribe (Watch *watch, Fixture *fixture, const gchar *path)
+{
+    g_queue_init (&watch->results);
+    watch->remote = fsguard_remote_subscribe (fixture->address, path, FALSE, watch_result, watch);
+}
+
+static void
+watch_unsubscribe (Watch *watch)
+{
+    fsguard_remote_unsubscribe (watch->remote);
+    g_queue_clear_full (&watch->results, g_free);
+}
+
+/* Returns the next result with status, skipping others, NULL when none
+ * came within timeout_ms */
+static Result *
+watch_wait_status (Watch *watch, gint status, guint timeout_ms)
+{
+    Result             *result;
+
+    while ((result = test_util_wait_pop (&watch->results, timeout_ms)) != NULL) {
+        if (result->status == status)
+            return result;
+        g_free (result);
+    }
+
+    return NULL;
+}
+
+static void
+frame_free (gpointer data)
+{
+    Frame *frame = data;
+
+    g_free (frame->path);
+    g_free (frame);
+}
+
+static gboolean
+fixture_peer_frame (FsGuardChannel *channel, const guint8 *payload, gsize len, gpointer user_data)
+{
+    Fixture            *fixture = user_data;
+    const guint8       *p = payload + 1;
+    const guint8       *end = payload + len;
+    guint64             id, flags = 0;
+    Frame              *frame;
+
+    g_assert_true (fsguard_wire_get_varint (&p, end, &id));
+    if (payload[0] == FSGUARD_WIRE_SUBSCRIBE)
+        g_assert_true (fsguard_wire_get_varint (&p, end, &flags));
+    else
+        g_assert_cmpint (payload[0], ==, FSGUARD_WIRE_UNSUBSCRIBE);
+
+    frame = g_new0 (Frame, 1);
+    frame->type = payload[0];
+    frame->id = id;
+    frame->flags = flags;
+    frame->path = g_strndup ((const gchar *) p, end - p);
+    g_queue_push_tail (&fixture->frames, frame);
+
+    return TRUE;
+}
+
+static void
+fixture_peer_closed (FsGuardChannel *channel, gpointer user_data)
+{
+    Fixture *fixture = user_data;
+
+    fsguard_channel_free (channel);
+    fixture->peer = NULL;
+}
+
+static gboolean
+fixture_peer_gone (gpointer user_data)
+{
+    Fixture *fixture = user_data;
+
+    return fixture->peer == NULL;
+}
+
+static gboolean
+fixture_incoming (GSocketService *service, GSocketConnection *connection,
+                  GObject *source_object, gpointer user_data)
+{
+    Fixture *fixture = user_data;
+
+    g_assert_null (fixture->peer);
+    fixture->connections++;
+    fixture->peer = fsguard_channel_new (connection, fixture_peer_frame,
+                                         fixture_peer_closed, fixture);
+
+    return TRUE;
+}
+
+static void
+fixture_fake_agent (Fixture *fixture)
+{
+    GSocketAddress     *address;
+    GError             *error = NULL;
+
+    fixture->service = g_socket_service_new ();
+    address = g_unix_socket_address_new (fixture->socket);
+    g_socket_listener_add_address (G_SOCKET_LISTENER (fixture->service), address,
+                                   G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_DEFAULT,
+                                   NULL, NULL, &error);
+    g_assert_no_error (error);
+    g_object_unref (address);
+    g_signal_connect (fixture->service, "incoming", G_CALLBACK (fixture_incoming), fixture);
+    g_socket_service_start (fixture->service);
+}
+
+static Frame *
+fixture_wait_frame (Fixture *fixture, guint type)
+{
+    Frame *frame = test_util_wait_pop (&fixture->frames, TEST_TIMEOUT_MS);
+
+    g_assert_nonnull (frame);
+    g_assert_cmpuint (frame->type, ==, type);
+
+    return frame;
+}
+
+static void
+fixture_send_sample (Fixture *fixture, guint id, guint flags, gint status,
+                     gint64 total_delta, gint64 avail_delta)
+{
+    GByteArray *frames = g_byte_array_new ();
+
+    fsguard_wire_put_sample (frames, id, flags, status, total_delta, avail_delta);
+    fsguard_channel_send (fixture->peer, frames);
+    g_byte_array_unref (frames);
+}
+
+static void
+fixture_set_up (Fixture *fixture, gconstpointer data)
+{
+    GError *error = NULL;
+
+    fixture->dir = g_dir_make_tmp ("fsguard-test-XXXXXX", &error);
+    g_assert_no_error (error);
+    fixture->socket = g_build_filename (fixture->dir, "agent.socket", NULL);
+    fixture->address = g_strconcat ("unix:", fixture->socket, NULL);
+    g_queue_init (&fixture->frames);
+}
+
+static void
+fixture_tear_down (Fixture *fixture, gconstpointer data)
+{
+    if (fixture->agent != NULL)
+        test_util_agent_quit (fixture->agent, fixture->socket);
+    if (fixture->service != NULL) {
+        if (fixture->peer != NULL)
+            fsguard_channel_free (fixture->peer);
+        g_socket_service_stop (fixture->service);
+        g_socket_listener_close (G_SOCKET_LISTENER (fixture->service));
+        g_object_unref (fixture->service);
+        g_unlink (fixture->socket);
+    }
+    g_queue_clear_full (&fixture->frames, frame_free);
+
+    g_rmdir (fixture->dir);
+    g_free (fixture->address);
+    g_free (fixture->socket);
+    g_free (fixture->dir);
+}
+
+static void
+test_remote_shared (Fixture *fixture, gconstpointer data)
+{
+    Watch               first, second;
+    Frame              *frame;
+    Result             *result;
+    guint               first_id = 0, second_id = 0;
+    guint               i;
+
+    fixture_fake_agent (fixture);
+
+    /* Both go through a single connection, with their own ids */
+    watch_subscribe (&first, fixture, "/first");
+    watch_subscribe (&second, fixture, "/second");
+    for (i = 0; i < 2; i++) {
+        frame = fixture_wait_frame (fixture, FSGUARD_WIRE_SUBSCRIBE);
+        if (g_strcmp0 (frame->path, "/first") == 0)
+            first_id = frame->id;
+        else if (g_strcmp0 (frame->path, "/second") == 0)
+            second_id = frame->id;
+        frame_free (frame);
+    }
+    g_assert_cmpuint (first_id, !=, 0);
+    g_assert_cmpuint (second_id, !=, 0);
+    g_assert_cmpuint (first_id, !=, second_id);
+    g_assert_cmpuint (fixture->connections, ==, 1);
+
+    /* Deltas add up per subscription */
+    fixture_send_sample (fixture, first_id, 0, FSGUARD_PROBE_OK, 1000, 600);
+    fixture_send_sample (fixture, second_id, 0, FSGUARD_PROBE_OK, 5000, 5000);
+    fixture_send_sample (fixture, first_id, FSGUARD_WIRE_MOUNT_CHANGED, FSGUARD_PROBE_OK, 0, -100);
+
+    result = test_util_wait_pop (&first.results, TEST_TIMEOUT_MS);
+    g_assert_nonnull (result);
+    g_assert_cmpint (result->status, ==, FSGUARD_PROBE_OK);
+    g_assert_cmpuint (result->total, ==, 1000);
+    g_assert_cmpuint (result->avail, ==, 600);
+    g_assert_false (result->mnt_changed);
+    g_free (result);
+    result = test_util_wait_pop (&first.results, TEST_TIMEOUT_MS);
+    g_assert_nonnull (result);
+    g_assert_cmpuint (result->total, ==, 1000);
+    g_assert_cmpuint (result->avail, ==, 500);
+    g_assert_true (result->mnt_changed);
+    g_free (result);
+    result = test_util_wait_pop (&second.results, TEST_TIMEOUT_MS);
+    g_assert_nonnull (result);
+    g_assert_cmpuint (result->total, ==, 5000);
+    g_assert_cmpuint (result->avail, ==, 5000);
+    g_free (result);
+
+    /* Only the last one going away closes the connection */
+    watch_unsubscribe (&first);
+    frame = fixture_wait_frame (fixture, FSGUARD_WIRE_UNSUBSCRIBE);
+    g_assert_cmpuint (frame->id, ==, first_id);
+    frame_free (frame);
+    g_assert_nonnull (fixture->peer);
+
+    /* Samples still on their way for it are dropped */
+    fixture_send_sample (fixture, first_id, 0, FSGUARD_PROBE_OK, 1, 1);
+    fixture_send_sample (fixture, second_id, 0, FSGUARD_PROBE_ERROR, -5000, -5000);
+    result = test_util_wait_pop (&second.results, TEST_TIMEOUT_MS);
+    g_assert_nonnull (result);
+    g_assert_cmpint (result->status, ==, FSGUARD_PROBE_ERROR);
+    g_free (result);
+
+    watch_unsubscribe (&second);
+    g_assert_true (test_util_wait (fixture_peer_gone, fixture, TEST_TIMEOUT_MS));
+    g_assert_cmpuint (fixture->connections, ==, 1);
+}
+
+static void
+test_remote_agent (Fixture *fixture, gconstpointer data)
+{
+    FsGuardProbe       *probe;
+    Watch               watch, missing;
+    Result             *result;
+    gchar              *path;
+
+    probe = fsguard_probe_new (fixture->dir, FALSE);
+    g_assert_cmpint (fsguard_probe_run (probe), ==, FSGUARD_PROBE_OK);
+
+    fixture->agent = test_util_agent_spawn (fixture->socket);
+    path = g_build_filename (fixture->dir, "missing", NULL);
+    watch_subscribe (&watch, fixture, fixture->dir);
+    watch_subscribe (&missing, fixture, path);
+    g_free (path);
+
+    result = watch_wait_status (&watch, FSGUARD_PROBE_OK, TEST_TIMEOUT_MS);
+    g_assert_nonnull (result);
+    g_assert_cmpuint (result->total, ==, probe->total);
+    g_free (result);
+    result = watch_wait_status (&missing, FSGUARD_PROBE_ERROR, TEST_TIMEOUT_MS);
+    g_assert_nonnull (result);
+    g_free (result);
+    watch_unsubscribe (&missing);
+
+    /* A crashed agent leaves its socket behind, the plugin tells the
+     * mount point is not responding */
+    g_subprocess_force_exit (fixture->agent);
+    g_subprocess_wait (fixture->agent, NULL, NULL);
+    g_clear_object (&fixture->agent);
+    result = watch_wait_status (&watch, FSGUARD_PROBE_HUNG, TEST_TIMEOUT_MS);
+    g_assert_nonnull (result);
+    g_free (result);
+
+    /* The next agent takes over the socket, the plugin reconnects and
+     * subscribes again, with sizes starting over from zero */
+    fixture->agent = test_util_agent_spawn (fixture->socket);
+    result = watch_wait_status (&watch, FSGUARD_PROBE_OK, RECONNECT_MS + TEST_TIMEOUT_MS);
+    g_assert_nonnull (result);
+    g_assert_cmpuint (result->total, ==, probe->total);
+    g_free (result);
+
+    watch_unsubscribe (&watch);
+    fsguard_probe_free (probe);
+}
+
+int
+main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add ("/remote/shared", Fixture, NULL,
+                fixture_set_up, test_remote_shared, fixture_tear_down);
+    g_test_add ("/remote/agent", Fixture, NULL,
+                fixture_set_up, test_remote_agent, fixture_tear_down);
+
+    return g_test_run ();
+}
@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Drives the check schedule of the plugin through the map and session
+ * changes it gets, and counts the checks it runs.  The battery interval
+ * is too long to ever fire during a test, so any check seen on battery is
+ * one too many.
+ */
+
+#undef G_DISABLE_ASSERT
+
+#include <gio/gio.h>
+
+#include "panel-plugin/fsguard-schedule.h"
+#include "test-util.h"
+
+#define INTERVAL_MS             50
+#define INTERVAL_BATTERY_MS     (10 * TEST_TIMEOUT_MS)
+/* Enough for the interval to fire a few times in a row */
+#define MIN_CHECKS              3
+
+typedef struct
+{
+    FsGuardSchedule    *schedule;
+    guint               checks;
+    guint               target;
+} Fixture;
+
+static void
+fixture_check (gpointer user_data)
+{
+    Fixture *fixture = user_data;
+
+    fixture->checks++;
+}
+
+static void
+fixture_setup (Fixture *fixture, gconstpointer user_data)
+{
+    fixture->schedule = fsguard_schedule_new (INTERVAL_MS, INTERVAL_BATTERY_MS,
+                                              fixture_check, fixture);
+}
+
+static void
+fixture_teardown (Fixture *fixture, gconstpointer user_data)
+{
+    fsguard_schedule_free (fixture->schedule);
+}
+
+static gboolean
+fixture_reached (gpointer user_data)
+{
+    Fixture *fixture = user_data;
+
+    return fixture->checks >= fixture->target;
+}
+
+/* Waits for the timer to run more checks */
+static void
+fixture_assert_ticking (Fixture *fixture)
+{
+    fixture->target = fixture->checks + MIN_CHECKS;
+    g_assert_true (test_util_wait (fixture_reached, fixture, TEST_TIMEOUT_MS));
+}
+
+/* Makes sure no check comes for a while */
+static void
+fixture_assert_quiet (Fixture *fixture)
+{
+    fixture->target = fixture->checks + 1;
+    g_assert_false (test_util_wait (fixture_reached, fixture, TEST_QUIET_MS));
+}
+
+static void
+test_schedule_mapped (Fixture *fixture, gconstpointer user_data)
+{
+    /* Not shown yet */
+    fixture_assert_quiet (fixture);
+    g_assert_cmpuint (fixture->checks, ==, 0);
+    g_assert_cmpuint (fsguard_schedule_get_interval (fixture->schedule), ==, 0);
+
+    /* The first check does not wait for the interval */
+    fsguard_schedule_set_mapped (fixture->schedule, TRUE);
+    g_assert_cmpuint (fixture->checks, ==, 1);
+    g_assert_cmpuint (fsguard_schedule_get_interval (fixture->schedule), ==, INTERVAL_MS);
+    fixture_assert_ticking (fixture);
+
+    /* Mapped again without an unmap in between, no extra check */
+    fixture->target = fixture->checks;
+    fsguard_schedule_set_mapped (fixture->schedule, TRUE);
+    g_assert_cmpuint (fixture->checks, ==, fixture->target);
+
+    fsguard_schedule_set_mapped (fixture->schedule, FALSE);
+    g_assert_cmpuint (fsguard_schedule_get_interval (fixture->schedule), ==, 0);
+    fixture_assert_quiet (fixture);
+
+    fixture->target = fixture->checks + 1;
+    fsguard_schedule_set_mapped (fixture->schedule, TRUE);
+    g_assert_cmpuint (fixture->checks, ==, fixture->target);
+    fixture_assert_ticking (fixture);
+}
+
+/* Pauses with the given hints, then clears them and expects a check
+ * right away */
+static void
+fixture_assert_resumes (Fixture *fixture, gboolean idle, gboolean locked)
+{
+    fsguard_schedule_set_session (fixture->schedule, idle, locked, FALSE);
+    g_assert_cmpuint (fsguard_schedule_get_interval (fixture->schedule), ==, 0);
+    fixture_assert_quiet (fixture);
+
+    fixture->target = fixture->checks + 1;
+    fsguard_schedule_set_session (fixture->schedule, FALSE, FALSE, FALSE);
+    g_assert_cmpuint (fixture->checks, ==, fixture->target);
+    g_assert_cmpuint (fsguard_schedule_get_interval (fixture->schedule), ==, INTERVAL_MS);
+    fixture_assert_ticking (fixture);
+}
+
+static void
+test_schedule_session (Fixture *fixture, gconstpointer user_data)
+{
+    fsguard_schedule_set_mapped (fixture->schedule, TRUE);
+    fixture_assert_ticking (fixture);
+
+    fixture_assert_resumes (fixture, TRUE, FALSE);
+    fixture_assert_resumes (fixture, FALSE, TRUE);
+    fixture_assert_resumes (fixture, TRUE, TRUE);
+
+    /* Unmapped while locked, unlocking alone does not resume */
+    fsguard_schedule_set_session (fixture->schedule, FALSE, TRUE, FALSE);
+    fsguard_schedule_set_mapped (fixture->schedule, FALSE);
+    fsguard_schedule_set_session (fixture->schedule, FALSE, FALSE, FALSE);
+    fixture_assert_quiet (fixture);
+}
+
+static void
+test_schedule_battery (Fixture *fixture, gconstpointer user_data)
+{
+    fsguard_schedule_set_mapped (fixture->schedule, TRUE);
+    fixture_assert_ticking (fixture);
+
+    /* Only spaced out, the last check is recent enough */
+    fixture->target = fixture->checks;
+    fsguard_schedule_set_session (fixture->schedule, FALSE, FALSE, TRUE);
+    g_assert_cmpuint (fixture->checks, ==, fixture->target);
+    g_assert_cmpuint (fsguard_schedule_get_interval (fixture->schedule), ==, INTERVAL_BATTERY_MS);
+    fixture_assert_quiet (fixture);
+
+    /* Resuming on battery still catches up, then stays on the long interval */
+    fsguard_schedule_set_session (fixture->schedule, FALSE, TRUE, TRUE);
+    g_assert_cmpuint (fsguard_schedule_get_interval (fixture->schedule), ==, 0);
+    fixture->target = fixture->checks + 1;
+    fsguard_schedule_set_session (fixture->schedule, FALSE, FALSE, TRUE);
+    g_assert_cmpuint (fixture->checks, ==, fixture->target);
+    g_assert_cmpuint (fsguard_schedule_get_interval (fixture->schedule), ==, INTERVAL_BATTERY_MS);
+    fixture_assert_quiet (fixture);
+
+    /* Back on AC */
+    fixture->target = fixture->checks;
+    fsguard_schedule_set_session (fixture->schedule, FALSE, FALSE, FALSE);
+    g_assert_cmpuint (fixture->checks, ==, fixture->target);
+    g_assert_cmpuint (fsguard_schedule_get_interval (fixture->schedule), ==, INTERVAL_MS);
+    fixture_assert_ticking (fixture);
+}
+
+int
+main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add ("/schedule/mapped", Fixture, NULL,
+                fixture_setup, test_schedule_mapped, fixture_teardown);
+    g_test_add ("/schedule/session", Fixture, NULL,
+                fixture_setup, test_schedule_session, fixture_teardown);
+    g_test_add ("/schedule/battery", Fixture, NULL,
+                fixture_setup, test_schedule_battery, fixture_teardown);
+
+    return g_test_run ();
+}
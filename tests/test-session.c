@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Prints the session state seen by the plugin each time it changes, for
+ * test-session.py to drive against a mock logind and upower.
+ */
+
+#include <stdio.h>
+
+#include <gio/gio.h>
+
+#include "panel-plugin/fsguard-session.h"
+
+static void
+session_changed (gboolean idle, gboolean locked, gboolean on_battery, gpointer user_data)
+{
+    printf ("idle=%d locked=%d on_battery=%d\n", idle, locked, on_battery);
+    fflush (stdout);
+}
+
+int
+main (int argc, char **argv)
+{
+    GMainLoop          *loop = g_main_loop_new (NULL, FALSE);
+    FsGuardSession     *session;
+
+    session = fsguard_session_new (session_changed, NULL);
+    g_main_loop_run (loop);
+
+    fsguard_session_free (session);
+    g_main_loop_unref (loop);
+
+    return 0;
+}
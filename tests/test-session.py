@@ -0,0 +1,126 @@
+#!/usr/bin/env python3
+#
+# Runs test-session against the logind and upower templates of
+# python-dbusmock on a private system bus, and changes the hints of the
+# session and the power supply the way the services do, with
+# PropertiesChanged on the path of their objects.
+
+import os
+import select
+import subprocess
+import sys
+import time
+import unittest
+
+try:
+    import dbus
+    import dbusmock
+except ImportError:
+    print('python-dbusmock is not installed, skipping')
+    sys.exit(77)
+
+LOGIND_NAME = 'org.freedesktop.login1'
+LOGIND_SESSION = 'org.freedesktop.login1.Session'
+UPOWER_NAME = 'org.freedesktop.UPower'
+TIMEOUT = 10
+
+
+class TestSession(dbusmock.DBusTestCase):
+    @classmethod
+    def setUpClass(cls):
+        cls.start_system_bus()
+        cls.dbus_con = cls.get_dbus(system_bus=True)
+
+    def setUp(self):
+        self.logind, self.logind_obj = self.spawn_server_template(
+            'logind', {}, stdout=subprocess.DEVNULL)
+        self.helper = None
+
+    def tearDown(self):
+        if self.helper is not None:
+            self.helper.terminate()
+            self.helper.wait()
+            self.helper.stdout.close()
+        self.logind.terminate()
+        self.logind.wait()
+
+    def add_session(self, session_id, uid, idle):
+        path = self.logind_obj.AddSession(session_id, 'seat0', uid, 'user%d' % uid, True,
+                                          dbus_interface=dbusmock.MOCK_IFACE)
+        session = self.dbus_con.get_object(LOGIND_NAME, path)
+        # Not there in all versions of the template
+        try:
+            session.AddProperty(LOGIND_SESSION, 'LockedHint', False,
+                                dbus_interface=dbusmock.MOCK_IFACE)
+        except dbus.exceptions.DBusException:
+            pass
+        self.update(session, IdleHint=idle)
+        return session
+
+    def update(self, session, **properties):
+        session.UpdateProperties(LOGIND_SESSION, properties,
+                                 dbus_interface=dbusmock.MOCK_IFACE)
+
+    def spawn_helper(self, session_id):
+        env = dict(os.environ)
+        if session_id is not None:
+            env['XDG_SESSION_ID'] = session_id
+        else:
+            env.pop('XDG_SESSION_ID', None)
+        self.helper = subprocess.Popen([os.environ['FSGUARD_TEST_SESSION']],
+                                       stdout=subprocess.PIPE, env=env,
+                                       universal_newlines=True)
+
+    def wait_state(self, expected):
+        deadline = time.monotonic() + TIMEOUT
+        seen = []
+        while time.monotonic() < deadline:
+            ready, _, _ = select.select([self.helper.stdout], [], [],
+                                        deadline - time.monotonic())
+            if not ready:
+                break
+            line = self.helper.stdout.readline().strip()
+            self.assertNotEqual(line, '', 'test-session exited')
+            if line == expected:
+                return
+            seen.append(line)
+        self.fail('%s not seen, only %s' % (expected, seen))
+
+    def test_hints(self):
+        # Another session first, so that the first one is not the right one
+        self.add_session('c1', 1000, False)
+        session = self.add_session('c2', 1001, True)
+        self.spawn_helper('c2')
+
+        # Idle from the start tells the proxy is on the session
+        self.wait_state('idle=1 locked=0 on_battery=0')
+
+        # And changes are seen, which they are not through session/auto
+        self.update(session, LockedHint=True)
+        self.wait_state('idle=1 locked=1 on_battery=0')
+        self.update(session, IdleHint=False)
+        self.wait_state('idle=0 locked=1 on_battery=0')
+        self.update(session, LockedHint=False)
+        self.wait_state('idle=0 locked=0 on_battery=0')
+
+    def test_on_battery(self):
+        upower, upower_obj = self.spawn_server_template(
+            'upower', {'OnBattery': True}, stdout=subprocess.DEVNULL)
+        try:
+            # Not from a logind session, the power supply is still followed
+            self.spawn_helper(None)
+            self.wait_state('idle=0 locked=0 on_battery=1')
+
+            upower_obj.UpdateProperties(UPOWER_NAME, {'OnBattery': False},
+                                        dbus_interface=dbusmock.MOCK_IFACE)
+            self.wait_state('idle=0 locked=0 on_battery=0')
+            upower_obj.UpdateProperties(UPOWER_NAME, {'OnBattery': True},
+                                        dbus_interface=dbusmock.MOCK_IFACE)
+            self.wait_state('idle=0 locked=0 on_battery=1')
+        finally:
+            upower.terminate()
+            upower.wait()
+
+
+if __name__ == '__main__':
+    unittest.main(testRunner=unittest.TextTestRunner(stream=sys.stdout, verbosity=2))
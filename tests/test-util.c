@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#undef G_DISABLE_ASSERT
+
+#include <signal.h>
+
+#include <gio/gunixsocketaddress.h>
+
+#include "test-util.h"
+
+static gboolean
+test_util_timeout (gpointer user_data)
+{
+    gboolean *expired = user_data;
+
+    *expired = TRUE;
+    return G_SOURCE_REMOVE;
+}
+
+/* Runs the main loop until done returns TRUE, FALSE when it did not within
+ * timeout_ms */
+gboolean
+test_util_wait (TestUtilDoneFunc done, gpointer user_data, guint timeout_ms)
+{
+    gboolean            expired = FALSE;
+    guint               source_id;
+
+    source_id = g_timeout_add (timeout_ms, test_util_timeout, &expired);
+    while (!done (user_data)) {
+        if (expired)
+            return FALSE;
+        g_main_context_iteration (NULL, TRUE);
+    }
+    if (!expired)
+        g_source_remove (source_id);
+
+    return TRUE;
+}
+
+static gboolean
+test_util_queue_filled (gpointer user_data)
+{
+    return !g_queue_is_empty (user_data);
+}
+
+/* Returns the head of queue, NULL when nothing came within timeout_ms */
+gpointer
+test_util_wait_pop (GQueue *queue, guint timeout_ms)
+{
+    test_util_wait (test_util_queue_filled, queue, timeout_ms);
+
+    return g_queue_pop_head (queue);
+}
+
+/* Starts xfce4-fsguard-agent on a unix socket, once it accepts connections */
+GSubprocess *
+test_util_agent_spawn (const gchar *socket)
+{
+    GSubprocess        *agent;
+    GError             *error = NULL;
+    gchar              *listen;
+
+    listen = g_strconcat ("unix:", socket, NULL);
+    agent = g_subprocess_new (G_SUBPROCESS_FLAGS_NONE, &error,
+                              g_getenv ("FSGUARD_AGENT"),
+                              "--listen", listen, "--interval", TEST_AGENT_INTERVAL, NULL);
+    g_assert_no_error (error);
+    g_free (listen);
+
+    g_object_unref (test_util_agent_connect (socket));
+
+    return agent;
+}
+
+/* The socket shows up once the agent is listening */
+GSocketConnection *
+test_util_agent_connect (const gchar *socket)
+{
+    GSocketConnection  *connection = NULL;
+    GSocketAddress     *address;
+    GSocketClient      *client;
+    gint64              deadline;
+
+    address = g_unix_socket_address_new (socket);
+    client = g_socket_client_new ();
+    deadline = g_get_monotonic_time () + TEST_TIMEOUT_MS * G_TIME_SPAN_MILLISECOND;
+    while (connection == NULL && g_get_monotonic_time () < deadline) {
+        connection = g_socket_client_connect (client, G_SOCKET_CONNECTABLE (address), NULL, NULL);
+        if (connection == NULL)
+            g_usleep (50 * G_TIME_SPAN_MILLISECOND);
+    }
+    g_assert_nonnull (connection);
+    g_object_unref (client);
+    g_object_unref (address);
+
+    return connection;
+}
+
+/* The agent removes its socket when asked to quit */
+void
+test_util_agent_quit (GSubprocess *agent, const gchar *socket)
+{
+    GError *error = NULL;
+
+    g_subprocess_send_signal (agent, SIGTERM);
+    g_subprocess_wait (agent, NULL, &error);
+    g_assert_no_error (error);
+    g_assert_true (g_subprocess_get_if_exited (agent));
+    g_assert_cmpint (g_subprocess_get_exit_status (agent), ==, 0);
+    g_assert_false (g_file_test (socket, G_FILE_TEST_EXISTS));
+    g_object_unref (agent);
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __TEST_UTIL_H__
+#define __TEST_UTIL_H__
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/* Exit status telling meson the test was skipped */
+#define TEST_EXIT_SKIP          77
+/* Only ever waited for in full when a test fails, keep it generous */
+#define TEST_TIMEOUT_MS         10000
+/* Long enough for something that is not supposed to happen to show up */
+#define TEST_QUIET_MS           1000
+/* Check interval of the agents started by the tests */
+#define TEST_AGENT_INTERVAL     "100"
+
+typedef gboolean (*TestUtilDoneFunc) (gpointer user_data);
+
+gboolean           test_util_wait          (TestUtilDoneFunc  done,
+                                            gpointer          user_data,
+                                            guint             timeout_ms);
+gpointer           test_util_wait_pop      (GQueue           *queue,
+                                            guint             timeout_ms);
+
+GSubprocess       *test_util_agent_spawn   (const gchar      *socket);
+GSocketConnection *test_util_agent_connect (const gchar      *socket);
+void               test_util_agent_quit    (GSubprocess      *agent,
+                                            const gchar      *socket);
+
+G_END_DECLS
+
+#endif /* !__TEST_UTIL_H__ */